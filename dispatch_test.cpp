@@ -0,0 +1,145 @@
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include "fast_math_dispatch.h"
+#include "tsc.h"
+
+
+// 不加 -march=native 编译（见 Makefile 中的 fat 目标），
+// 运行时按 CPU 选择实现；可用 FAST_MATH_ISA=avx2 / scalar 强制降级对比
+int main(){
+
+    srand(time(NULL));
+
+    size_t length;
+    std::cin >> length;
+
+    double *x_data = new double[length];
+    double *y_data = new double[length];
+    for (size_t i = 0; i < length; ++i){
+        x_data[i] = 200.0*rand()/RAND_MAX;
+        y_data[i] = 200.0*rand()/RAND_MAX - 100;
+    }
+
+    double *out = new double[length];
+
+    std::string split = "====================";
+
+    std::cout << "dispatched isa: " << FAST_MATH_DISPATCH::isa_name() << std::endl;
+
+    /* 各档实现对同一输入应给出相同结果：全是 NaN 时 imin / imax 都返回 (uint64_t)(-1)，与长度无关 */
+    {
+        const FAST_MATH_DISPATCH::KERNEL_TABLE *tables[3] = {
+            &FAST_MATH_DISPATCH::scalar_table, &FAST_MATH_DISPATCH::avx2_table, &FAST_MATH_DISPATCH::avx512_table};
+        const size_t nan_lens[] = {1, 7, 64, 127, 128, 1000};
+        double *nan_data = new double[1000];
+        for (size_t i = 0; i < 1000; ++i){
+            nan_data[i] = NAN;
+        }
+        for (size_t len : nan_lens){
+            for (int level = 0; level <= FAST_MATH_DISPATCH::isa(); ++level){
+                size_t imin_index = tables[level]->imin(nan_data, len), imax_index = tables[level]->imax(nan_data, len);
+                if (imin_index != (size_t)-1 || imax_index != (size_t)-1){
+                    printf("F\tall-NaN len %zu, level %d: imin %zu, imax %zu\n", len, level, imin_index, imax_index);
+                }
+            }
+        }
+        delete[] nan_data;
+    }
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "SIMPLE_MATH::sum", 
+        res = SIMPLE_MATH::sum(x_data, length);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH_DISPATCH::sum", 
+        res = FAST_MATH_DISPATCH::sum(x_data, length);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "SIMPLE_MATH::var", 
+        res = SIMPLE_MATH::var(x_data, length, false);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH_DISPATCH::var", 
+        res = FAST_MATH_DISPATCH::var(x_data, length, false);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "SIMPLE_MATH::covar", 
+        res = SIMPLE_MATH::covar(x_data, y_data, length, false);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH_DISPATCH::covar", 
+        res = FAST_MATH_DISPATCH::covar(x_data, y_data, length, false);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "SIMPLE_MATH::vec_log2", 
+        SIMPLE_MATH::vec_log2(x_data, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH_DISPATCH::vec_log2", 
+        FAST_MATH_DISPATCH::vec_log2(x_data, length, out);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "SIMPLE_MATH::ema", 
+        for (int i = 0; i < 100; ++i)
+        res = SIMPLE_MATH::ema(x_data, length/5, length);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH_DISPATCH::ema", 
+        for (int i = 0; i < 100; ++i)
+        res = FAST_MATH_DISPATCH::ema(x_data, length/5, length);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "SIMPLE_MATH::beta", 
+        res = SIMPLE_MATH::beta(x_data, y_data, length);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH_DISPATCH::beta", 
+        res = FAST_MATH_DISPATCH::beta(x_data, y_data, length);
+    )
+
+
+    
+    return 0;
+}
@@ -0,0 +1,1429 @@
+#ifndef FAST_MATH_AVX2_H
+#define FAST_MATH_AVX2_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+#include <immintrin.h>
+#include <math.h>
+
+
+// FAST_MATH 的 AVX2 + FMA 版本，接口与 FAST_MATH 一一对应，
+// 供不支持 AVX-512 的 CPU 使用（见 fast_math_dispatch.h）；
+// AVX2 没有 mask 寄存器，NaN 通过 _CMP_ORD_Q 比较得到的全 1 / 全 0 向量屏蔽，
+// 结果与 FAST_MATH 中 exp_mask / frac_mask 的判断一致：只忽略 NaN，不忽略 inf
+#pragma GCC push_options
+#pragma GCC target("avx2,fma,popcnt")
+
+namespace FAST_MATH_AVX2
+{
+    typedef double (*UNI_FUNC)(double);
+    typedef double (*BIN_FUNC)(double, double);
+    typedef __m256d (*AVX_UNI_FUNC)(__m256d);
+    typedef __m256d (*AVX_BIN_FUNC)(__m256d, __m256d);
+
+
+    #define FAST_MATH_AVX2_SET1_EPI64(x) {(long long)(x), (long long)(x), (long long)(x), (long long)(x)}
+
+    static const __m256i exp_mask = FAST_MATH_AVX2_SET1_EPI64(0x7ff0000000000000),
+                        frac_mask = FAST_MATH_AVX2_SET1_EPI64(0x000fffffffffffff),
+                        sign_mask = FAST_MATH_AVX2_SET1_EPI64(0x8000000000000000),
+                        exp_set = FAST_MATH_AVX2_SET1_EPI64(0x3ff0000000000000),
+                        exp_sub = FAST_MATH_AVX2_SET1_EPI64(1023),
+                        cvt_magic = FAST_MATH_AVX2_SET1_EPI64(0x4338000000000000),
+                        lane_index = {0, 1, 2, 3};
+
+    #undef FAST_MATH_AVX2_SET1_EPI64
+
+
+    /**
+     * @brief 生成尾部掩码：低 len 个 lane 为全 1，其余为 0
+     */
+    __attribute__((__always_inline__)) inline __m256i
+    tail_mask(size_t len)
+    {
+        return _mm256_cmpgt_epi64(_mm256_set1_epi64x(len), lane_index);
+    }
+
+
+    /**
+     * @brief 非 NaN 的 lane 为全 1，NaN 的 lane 为 0
+     */
+    __attribute__((__always_inline__)) inline __m256d
+    valid_mask(__m256d x)
+    {
+        return _mm256_cmp_pd(x, x, _CMP_ORD_Q);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    reduce_add_pd(__m256d x)
+    {
+        __m128d avx_tmp = _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(avx_tmp, _mm_unpackhi_pd(avx_tmp, avx_tmp)));
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    reduce_min_pd(__m256d x)
+    {
+        __m128d avx_tmp = _mm_min_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+        return _mm_cvtsd_f64(_mm_min_sd(avx_tmp, _mm_unpackhi_pd(avx_tmp, avx_tmp)));
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    reduce_max_pd(__m256d x)
+    {
+        __m128d avx_tmp = _mm_max_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(avx_tmp, _mm_unpackhi_pd(avx_tmp, avx_tmp)));
+    }
+
+
+    /**
+     * @brief 统计 valid 中全 1 的 lane 个数
+     */
+    __attribute__((__always_inline__)) inline size_t
+    count_valid(__m256d valid)
+    {
+        return _mm_popcnt_u32(_mm256_movemask_pd(valid));
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    pow2(double x)
+    {
+        return x * x;
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    pow3(double x)
+    {
+        return x * x * x;
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    pow4(double x)
+    {
+        return pow2(pow2(x));
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    mul(double x, double y)
+    {
+        return x * y;
+    }
+
+
+    __attribute__((__always_inline__)) inline __m256d
+    avx_pow2(__m256d x)
+    {
+        return _mm256_mul_pd(x, x);
+    }
+
+
+    __attribute__((__always_inline__)) inline __m256d
+    avx_pow3(__m256d x)
+    {
+        return _mm256_mul_pd(x, _mm256_mul_pd(x, x));
+    }
+
+
+    __attribute__((__always_inline__)) inline __m256d
+    avx_pow4(__m256d x)
+    {
+        return avx_pow2(avx_pow2(x));
+    }
+
+
+    __attribute__((__always_inline__)) inline __m256d
+    avx_mul(__m256d x, __m256d y)
+    {
+        return _mm256_mul_pd(x, y);
+    }
+
+
+    /**
+     * @brief 将数组中的 double 累加；忽略NaN
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return 数组中 double 的和
+     */
+    __attribute__((__always_inline__)) inline double
+    sum(const double *data, size_t nLength)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d sum = _mm256_setzero_pd(), incre;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = _mm256_loadu_pd(data+index);
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid_mask(incre)));
+            }
+            incre = _mm256_maskload_pd(data+index, tail_mask(nLength & 0x3));
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid_mask(incre)));
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0;
+            for (size_t index = 0; index != nLength; ++index){
+                if (!isnan(data[index])){
+                    res += data[index];
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 对数组中的每个数进行一元函数操作后再累加；忽略NaN：
+     *        若 func(data[i]) 为 NaN，则忽略 i 位置
+     * @param func 一元函数 double -> double
+     * @param avx_func 批量一元函数 __m256d -> __m256d
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return sum(func(data[i]))
+     */
+    __attribute__((__always_inline__)) inline double
+    unifunc_sum(UNI_FUNC func, AVX_UNI_FUNC avx_func,
+                const double *data, size_t nLength)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d sum = _mm256_setzero_pd(), incre, valid;
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = avx_func(_mm256_loadu_pd(data+index));
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid_mask(incre)));
+            }
+            mask = tail_mask(nLength & 0x3);
+            incre = avx_func(_mm256_maskload_pd(data+index, mask));
+            valid = _mm256_and_pd(valid_mask(incre), _mm256_castsi256_pd(mask));
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0, tmp;
+            for (size_t index = 0; index != nLength; ++index){
+                tmp = func(data[index]);
+                if (!isnan(tmp)){
+                    res += tmp;
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 对数组中的每个数先减去 sub，再进行一元函数操作，最后累加；忽略NaN：
+     *        若 func(data[i]-sub) 为 NaN，则忽略 i 位置
+     * @param func 一元函数 double -> double
+     * @param avx_func 批量一元函数 __m256d -> __m256d
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return sum(func(data[i]-sub))
+     */
+    __attribute__((__always_inline__)) inline double
+    sub_unifunc_sum(UNI_FUNC func, AVX_UNI_FUNC avx_func,
+                    const double *data, double sub, size_t nLength)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d sum = _mm256_setzero_pd(), incre, valid,
+                    avx_sub = _mm256_set1_pd(sub);
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = avx_func(_mm256_sub_pd(_mm256_loadu_pd(data+index), avx_sub));
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid_mask(incre)));
+            }
+            mask = tail_mask(nLength & 0x3);
+            incre = avx_func(_mm256_sub_pd(_mm256_maskload_pd(data+index, mask), avx_sub));
+            valid = _mm256_and_pd(valid_mask(incre), _mm256_castsi256_pd(mask));
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0, tmp;
+            for (size_t index = 0; index != nLength; ++index){
+                tmp = func(data[index]-sub);
+                if (!isnan(tmp)){
+                    res += tmp;
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 对两个数组中的每对数进行二元函数操作后再累加；忽略NaN：
+     *        若 func(x_data[i], y_data[i]) 为 NaN，则忽略 i 位置
+     * @param func 二元函数 (double, double) -> double
+     * @param avx_func 批量二元函数 (__m256d, __m256d) -> __m256d
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @return sum(func(x_data[i], y_data[i]))
+     */
+    __attribute__((__always_inline__)) inline double
+    binfunc_sum(BIN_FUNC func, AVX_BIN_FUNC avx_func,
+                const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d sum = _mm256_setzero_pd(), incre, valid;
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = avx_func(_mm256_loadu_pd(x_data+index), _mm256_loadu_pd(y_data+index));
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid_mask(incre)));
+            }
+            mask = tail_mask(nLength & 0x3);
+            incre = avx_func(_mm256_maskload_pd(x_data+index, mask), _mm256_maskload_pd(y_data+index, mask));
+            valid = _mm256_and_pd(valid_mask(incre), _mm256_castsi256_pd(mask));
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0, tmp;
+            for (size_t index = 0; index != nLength; ++index){
+                tmp = func(x_data[index], y_data[index]);
+                if (!isnan(tmp)){
+                    res += tmp;
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 对两个数组中的每对数先做减法，再进行二元函数操作，最后累加；忽略 NaN：
+     *        若 func(x_data[i]-x_sub, y_data[i]-y_sub) 为 NaN，则忽略 i 位置
+     * @param func 二元函数 (double, double) -> double
+     * @param avx_func 批量二元函数 (__m256d, __m256d) -> __m256d
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @return sum(func(x_data[i]-x_sub, y_data[i]-y_sub))
+     */
+    __attribute__((__always_inline__)) inline double
+    sub_binfunc_sum(BIN_FUNC func, AVX_BIN_FUNC avx_func,
+                    const double * __restrict__ x_data, double x_sub,
+                    const double * __restrict__ y_data, double y_sub, size_t nLength)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d sum = _mm256_setzero_pd(), incre, valid,
+                    avx_x_sub = _mm256_set1_pd(x_sub),
+                    avx_y_sub = _mm256_set1_pd(y_sub);
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = avx_func(_mm256_sub_pd(_mm256_loadu_pd(x_data+index), avx_x_sub),
+                                _mm256_sub_pd(_mm256_loadu_pd(y_data+index), avx_y_sub));
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid_mask(incre)));
+            }
+            mask = tail_mask(nLength & 0x3);
+            incre = avx_func(_mm256_sub_pd(_mm256_maskload_pd(x_data+index, mask), avx_x_sub),
+                            _mm256_sub_pd(_mm256_maskload_pd(y_data+index, mask), avx_y_sub));
+            valid = _mm256_and_pd(valid_mask(incre), _mm256_castsi256_pd(mask));
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0, tmp;
+            for (size_t index = 0; index != nLength; ++index){
+                tmp = func(x_data[index]-x_sub, y_data[index]-y_sub);
+                if (!isnan(tmp)){
+                    res += tmp;
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 将数组中的 double 累加；忽略NaN，
+     *        将去除 NaN 之后的数组长度存储在 valid_len 中
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return 数组中 double 的和
+     */
+    __attribute__((__always_inline__)) inline double
+    sum_len(const double *data, size_t nLength, size_t *valid_len)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index, count = 0;
+            __m256d sum = _mm256_setzero_pd(), incre, valid;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = _mm256_loadu_pd(data+index);
+                valid = valid_mask(incre);
+                count += count_valid(valid);
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            }
+            incre = _mm256_maskload_pd(data+index, tail_mask(nLength & 0x3));
+            valid = valid_mask(incre);
+            count += count_valid(valid) - (4 - (nLength & 0x3));
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            *valid_len = count;
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0;
+            *valid_len = nLength;
+            for (size_t index = 0; index != nLength; ++index){
+                if (isnan(data[index])){
+                    --*valid_len;
+                }
+                else{
+                    res += data[index];
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 对数组中的每个数进行一元函数操作后再累加；忽略NaN：
+     *        若 func(data[i]) 为 NaN，则忽略 i 位置；
+     *        将忽略 NaN 之后的数组长度存储在 valid_len 中
+     * @param func 一元函数 double -> double
+     * @param avx_func 批量一元函数 __m256d -> __m256d
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return sum(func(data[i]))
+     */
+    __attribute__((__always_inline__)) inline double
+    unifunc_sum_len(UNI_FUNC func, AVX_UNI_FUNC avx_func,
+                const double *data, size_t nLength, size_t *valid_len)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index, count = 0;
+            __m256d sum = _mm256_setzero_pd(), incre, valid;
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = avx_func(_mm256_loadu_pd(data+index));
+                valid = valid_mask(incre);
+                count += count_valid(valid);
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            }
+            mask = tail_mask(nLength & 0x3);
+            incre = avx_func(_mm256_maskload_pd(data+index, mask));
+            valid = _mm256_and_pd(valid_mask(incre), _mm256_castsi256_pd(mask));
+            count += count_valid(valid);
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            *valid_len = count;
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0, tmp;
+            *valid_len = nLength;
+            for (size_t index = 0; index != nLength; ++index){
+                tmp = func(data[index]);
+                if (isnan(tmp)){
+                    --*valid_len;
+                }
+                else{
+                    res += tmp;
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 对数组中的每个数先减去 sub，再进行一元函数操作，最后累加；忽略NaN：
+     *        若 func(data[i]-sub) 为 NaN，则忽略 i 位置；
+     *        将忽略 NaN 之后的数组长度存储在 valid_len 中
+     * @param func 一元函数 double -> double
+     * @param avx_func 批量一元函数 __m256d -> __m256d
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return sum(func(data[i]-sub))
+     */
+    __attribute__((__always_inline__)) inline double
+    sub_unifunc_sum_len(UNI_FUNC func, AVX_UNI_FUNC avx_func,
+                    const double *data, double sub,
+                    size_t nLength, size_t *valid_len)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index, count = 0;
+            __m256d sum = _mm256_setzero_pd(), incre, valid,
+                    avx_sub = _mm256_set1_pd(sub);
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = avx_func(_mm256_sub_pd(_mm256_loadu_pd(data+index), avx_sub));
+                valid = valid_mask(incre);
+                count += count_valid(valid);
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            }
+            mask = tail_mask(nLength & 0x3);
+            incre = avx_func(_mm256_sub_pd(_mm256_maskload_pd(data+index, mask), avx_sub));
+            valid = _mm256_and_pd(valid_mask(incre), _mm256_castsi256_pd(mask));
+            count += count_valid(valid);
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            *valid_len = count;
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0, tmp;
+            *valid_len = nLength;
+            for (size_t index = 0; index != nLength; ++index){
+                tmp = func(data[index]-sub);
+                if (isnan(tmp)){
+                    --*valid_len;
+                }
+                else{
+                    res += tmp;
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 对两个数组中的每对数进行二元函数操作后再累加；忽略NaN：
+     *        若 func(x_data[i], y_data[i]) 为 NaN，则忽略 i 位置；
+     *        将忽略 NaN 之后的数组长度存储在 valid_len 中
+     * @param func 二元函数 (double, double) -> double
+     * @param avx_func 批量二元函数 (__m256d, __m256d) -> __m256d
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @return sum(func(x_data[i], y_data[i]))
+     */
+    __attribute__((__always_inline__)) inline double
+    binfunc_sum_len(BIN_FUNC func, AVX_BIN_FUNC avx_func,
+                const double * __restrict__ x_data, const double * __restrict__ y_data,
+                size_t nLength, size_t *valid_len)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index, count = 0;
+            __m256d sum = _mm256_setzero_pd(), incre, valid;
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = avx_func(_mm256_loadu_pd(x_data+index), _mm256_loadu_pd(y_data+index));
+                valid = valid_mask(incre);
+                count += count_valid(valid);
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            }
+            mask = tail_mask(nLength & 0x3);
+            incre = avx_func(_mm256_maskload_pd(x_data+index, mask), _mm256_maskload_pd(y_data+index, mask));
+            valid = _mm256_and_pd(valid_mask(incre), _mm256_castsi256_pd(mask));
+            count += count_valid(valid);
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            *valid_len = count;
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0, tmp;
+            *valid_len = nLength;
+            for (size_t index = 0; index != nLength; ++index){
+                tmp = func(x_data[index], y_data[index]);
+                if (isnan(tmp)){
+                    --*valid_len;
+                }
+                else{
+                    res += tmp;
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 对两个数组中的每对数先做减法，再进行二元函数操作，最后累加；忽略 NaN：
+     *        若 func(x_data[i]-x_sub, y_data[i]-y_sub) 为 NaN，则忽略 i 位置；
+     *        将忽略 NaN 之后的数组长度存储在 valid_len 中
+     * @param func 二元函数 (double, double) -> double
+     * @param avx_func 批量二元函数 (__m256d, __m256d) -> __m256d
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @return sum(func(x_data[i]-x_sub, y_data[i]-y_sub))
+     */
+    __attribute__((__always_inline__)) inline double
+    sub_binfunc_sum_len(BIN_FUNC func, AVX_BIN_FUNC avx_func,
+                    const double * __restrict__ x_data, double x_sub,
+                    const double * __restrict__ y_data, double y_sub,
+                    size_t nLength, size_t *valid_len)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index, count = 0;
+            __m256d sum = _mm256_setzero_pd(), incre, valid,
+                    avx_x_sub = _mm256_set1_pd(x_sub),
+                    avx_y_sub = _mm256_set1_pd(y_sub);
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                incre = avx_func(_mm256_sub_pd(_mm256_loadu_pd(x_data+index), avx_x_sub),
+                                _mm256_sub_pd(_mm256_loadu_pd(y_data+index), avx_y_sub));
+                valid = valid_mask(incre);
+                count += count_valid(valid);
+                sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            }
+            mask = tail_mask(nLength & 0x3);
+            incre = avx_func(_mm256_sub_pd(_mm256_maskload_pd(x_data+index, mask), avx_x_sub),
+                            _mm256_sub_pd(_mm256_maskload_pd(y_data+index, mask), avx_y_sub));
+            valid = _mm256_and_pd(valid_mask(incre), _mm256_castsi256_pd(mask));
+            count += count_valid(valid);
+            sum = _mm256_add_pd(sum, _mm256_and_pd(incre, valid));
+            *valid_len = count;
+            return reduce_add_pd(sum);
+        }
+        else{
+            double res = 0, tmp;
+            *valid_len = nLength;
+            for (size_t index = 0; index != nLength; ++index){
+                tmp = func(x_data[index]-x_sub, y_data[index]-y_sub);
+                if (isnan(tmp)){
+                    --*valid_len;
+                }
+                else{
+                    res += tmp;
+                }
+            }
+            return res;
+        }
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    mean(const double *data, size_t nLength)
+    {
+        double data_sum = sum_len(data, nLength, &nLength);
+        return data_sum / nLength;
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    unifunc_mean(UNI_FUNC func, AVX_UNI_FUNC avx_func,
+                const double *data, size_t nLength)
+    {
+        double data_sum = unifunc_sum_len(func, avx_func, data, nLength, &nLength);
+        return data_sum / nLength;
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sub_unifunc_mean(UNI_FUNC func, AVX_UNI_FUNC avx_func,
+                    const double *data, double sub, size_t nLength)
+    {
+        double data_sum = sub_unifunc_sum_len(func, avx_func, data, sub, nLength, &nLength);
+        return data_sum / nLength;
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    binfunc_mean(BIN_FUNC func, AVX_BIN_FUNC avx_func,
+                const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength)
+    {
+        double data_sum = binfunc_sum_len(func, avx_func, x_data, y_data, nLength, &nLength);
+        return data_sum / nLength;
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sub_binfunc_mean(BIN_FUNC func, AVX_BIN_FUNC avx_func,
+                    const double * __restrict__ x_data, double x_sub,
+                    const double * __restrict__ y_data, double y_sub, size_t nLength)
+    {
+        double data_sum = sub_binfunc_sum_len(func, avx_func, x_data, x_sub,
+                                            y_data, y_sub, nLength, &nLength);
+        return data_sum / nLength;
+    }
+
+
+    /**
+     * @brief 求数组中 double 的最小值，忽略 NaN；
+     *        如果数组中全是 NaN，则返回 INFINITY
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return 数组中 double 的最小值
+     */
+    __attribute__((__always_inline__)) inline double
+    min(const double *data, size_t nLength)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d avx_min = _mm256_set1_pd(INFINITY), avx_tmp;
+            __m256i mask;
+
+            // _mm256_min_pd 在任一操作数为 NaN 时返回第二个操作数，因此 NaN 被跳过
+            for (index = 0; index != avx_len; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                avx_min = _mm256_min_pd(avx_tmp, avx_min);
+            }
+            mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            avx_min = _mm256_blendv_pd(avx_min, _mm256_min_pd(avx_tmp, avx_min), _mm256_castsi256_pd(mask));
+            return reduce_min_pd(avx_min);
+        }
+        else{
+            double res = INFINITY;
+            for (size_t index = 0; index != nLength; ++index){
+                if (res > data[index]){
+                    res = data[index];
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 求数组中 double 最小值的索引，忽略 NaN；
+     *        如果数组中全是 NaN, 则返回 (uint64_t)(-1)
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return 数组中最小值所在的索引
+     */
+    __attribute__((__always_inline__)) inline size_t
+    imin(const double *data, size_t nLength)
+    {
+        if (nLength & ~0x3f){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d avx_min = _mm256_set1_pd(INFINITY), avx_tmp, index_mask;
+            __m256i avx_index = _mm256_set_epi64x(-1, -2, -3, -4);
+            __m256i avx_min_index = _mm256_set1_epi64x(-1), avx_index_incre = _mm256_set1_epi64x(4), mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                avx_index = _mm256_add_epi64(avx_index, avx_index_incre);
+                index_mask = _mm256_cmp_pd(avx_tmp, avx_min, _CMP_LT_OQ);
+                avx_min_index = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(avx_min_index),
+                                                    _mm256_castsi256_pd(avx_index), index_mask));
+                avx_min = _mm256_blendv_pd(avx_min, avx_tmp, index_mask);
+            }
+            mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            avx_index = _mm256_add_epi64(avx_index, avx_index_incre);
+            index_mask = _mm256_and_pd(_mm256_cmp_pd(avx_tmp, avx_min, _CMP_LT_OQ), _mm256_castsi256_pd(mask));
+            avx_min_index = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(avx_min_index),
+                                                _mm256_castsi256_pd(avx_index), index_mask));
+            avx_min = _mm256_blendv_pd(avx_min, avx_tmp, index_mask);
+
+            double vec_min[4] __attribute__((__aligned__(32)));
+            uint64_t vec_index[4] __attribute__((__aligned__(32)));
+            _mm256_store_pd(vec_min, avx_min);
+            _mm256_store_si256((__m256i *)vec_index, avx_min_index);
+            double min_val = *vec_min;
+            uint64_t min_index = *vec_index;
+
+            #pragma GCC unroll 4
+            for (uint8_t i = 1; i != 4; ++i){
+                if (vec_min[i] < min_val){
+                    min_index = vec_index[i];
+                    min_val = vec_min[i];
+                }
+            }
+            return min_index;
+        }
+        else{
+            double res = INFINITY;
+            size_t index = -1;
+            for (size_t i = 0; i != nLength; ++i){
+                if (res > data[i]){
+                    res = data[i];
+                    index = i;
+                }
+            }
+            return index;
+        }
+    }
+
+
+    /**
+     * @brief 求数组中 double 的最大值，忽略 NaN；
+     *        如果数组中全是 NaN，则返回 -INFINITY
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return 数组中 double 的最大值
+     */
+    __attribute__((__always_inline__)) inline double
+    max(const double *data, size_t nLength)
+    {
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d avx_max = _mm256_set1_pd(-INFINITY), avx_tmp;
+            __m256i mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                avx_max = _mm256_max_pd(avx_tmp, avx_max);
+            }
+            mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            avx_max = _mm256_blendv_pd(avx_max, _mm256_max_pd(avx_tmp, avx_max), _mm256_castsi256_pd(mask));
+            return reduce_max_pd(avx_max);
+        }
+        else{
+            double res = -INFINITY;
+            for (size_t index = 0; index != nLength; ++index){
+                if (res < data[index]){
+                    res = data[index];
+                }
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief 求数组中 double 最大值的索引，忽略 NaN；
+     *        如果数组中全是 NaN, 则返回 (uint64_t)(-1)
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return 数组中最大值所在的索引
+     */
+    __attribute__((__always_inline__)) inline size_t
+    imax(const double *data, size_t nLength)
+    {
+        if (nLength & ~0x3f){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d avx_max = _mm256_set1_pd(-INFINITY), avx_tmp, index_mask;
+            __m256i avx_index = _mm256_set_epi64x(-1, -2, -3, -4);
+            __m256i avx_max_index = _mm256_set1_epi64x(-1), avx_index_incre = _mm256_set1_epi64x(4), mask;
+
+            for (index = 0; index != avx_len; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                avx_index = _mm256_add_epi64(avx_index, avx_index_incre);
+                index_mask = _mm256_cmp_pd(avx_max, avx_tmp, _CMP_LT_OQ);
+                avx_max_index = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(avx_max_index),
+                                                    _mm256_castsi256_pd(avx_index), index_mask));
+                avx_max = _mm256_blendv_pd(avx_max, avx_tmp, index_mask);
+            }
+            mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            avx_index = _mm256_add_epi64(avx_index, avx_index_incre);
+            index_mask = _mm256_and_pd(_mm256_cmp_pd(avx_max, avx_tmp, _CMP_LT_OQ), _mm256_castsi256_pd(mask));
+            avx_max_index = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(avx_max_index),
+                                                _mm256_castsi256_pd(avx_index), index_mask));
+            avx_max = _mm256_blendv_pd(avx_max, avx_tmp, index_mask);
+
+            double vec_max[4] __attribute__((__aligned__(32)));
+            uint64_t vec_index[4] __attribute__((__aligned__(32)));
+            _mm256_store_pd(vec_max, avx_max);
+            _mm256_store_si256((__m256i *)vec_index, avx_max_index);
+            double max_val = *vec_max;
+            uint64_t max_index = *vec_index;
+
+            #pragma GCC unroll 4
+            for (uint8_t i = 1; i != 4; ++i){
+                if (vec_max[i] > max_val){
+                    max_index = vec_index[i];
+                    max_val = vec_max[i];
+                }
+            }
+            return max_index;
+        }
+        else{
+            double res = -INFINITY;
+            size_t index = -1;
+            for (size_t i = 0; i != nLength; ++i){
+                if (res < data[i]){
+                    res = data[i];
+                    index = i;
+                }
+            }
+            return index;
+        }
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    var(const double *data, size_t nLength, bool bias)
+    {
+        size_t valid_len;
+        double data_sum = sum_len(data, nLength, &valid_len);
+        double up = unifunc_sum(pow2, avx_pow2, data, nLength) - data_sum * data_sum / valid_len;
+        if (bias){
+            return up / valid_len;
+        }
+        else{
+            return up / (valid_len-1);
+        }
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    std(const double *data, size_t nLength, bool bias)
+    {
+        return sqrt(var(data, nLength, bias));
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    dot(const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength)
+    {
+        double data_sum = binfunc_sum_len(mul, avx_mul, x_data, y_data, nLength, &nLength);
+        return data_sum / nLength;
+    }
+
+
+    /**
+     * @brief 两组数的协方差，忽略 NaN：
+     *        若某组数某处为 NaN，则两组数的该位置都被忽略
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @param bias 是否为有偏估计
+     * @return 两组数的协方差
+     */
+    __attribute__((__always_inline__)) inline double
+    covar(const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength, bool bias)
+    {
+        double res;
+        size_t valid_len = nLength;
+
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d avx_x, avx_x_sum, avx_y, avx_y_sum,
+                    avx_mul, avx_mul_sum, valid;
+            __m256i mask;
+            double x_sum, y_sum;
+
+            valid_len = 0;
+            avx_mul_sum = avx_y_sum = avx_x_sum = _mm256_setzero_pd();
+            for (index = 0; index != avx_len; index += 4){
+                avx_x = _mm256_loadu_pd(x_data+index);
+                avx_y = _mm256_loadu_pd(y_data+index);
+                avx_mul = _mm256_mul_pd(avx_x, avx_y);
+                valid = valid_mask(avx_mul);
+                valid_len += count_valid(valid);
+                avx_x_sum = _mm256_add_pd(avx_x_sum, _mm256_and_pd(avx_x, valid));
+                avx_y_sum = _mm256_add_pd(avx_y_sum, _mm256_and_pd(avx_y, valid));
+                avx_mul_sum = _mm256_add_pd(avx_mul_sum, _mm256_and_pd(avx_mul, valid));
+            }
+            mask = tail_mask(nLength & 0x3);
+            avx_x = _mm256_maskload_pd(x_data+index, mask);
+            avx_y = _mm256_maskload_pd(y_data+index, mask);
+            avx_mul = _mm256_mul_pd(avx_x, avx_y);
+            valid = _mm256_and_pd(valid_mask(avx_mul), _mm256_castsi256_pd(mask));
+            valid_len += count_valid(valid);
+            avx_x_sum = _mm256_add_pd(avx_x_sum, _mm256_and_pd(avx_x, valid));
+            avx_y_sum = _mm256_add_pd(avx_y_sum, _mm256_and_pd(avx_y, valid));
+            avx_mul_sum = _mm256_add_pd(avx_mul_sum, _mm256_and_pd(avx_mul, valid));
+            x_sum = reduce_add_pd(avx_x_sum);
+            y_sum = reduce_add_pd(avx_y_sum);
+            res = reduce_add_pd(avx_mul_sum) - x_sum * y_sum / valid_len;
+        }
+        else{
+            double x_sum, y_sum, mul_sum, mul_tmp;
+            x_sum = y_sum = mul_sum = 0;
+            for (size_t i = 0; i != nLength; ++i){
+                mul_tmp = x_data[i] * y_data[i];
+                if (isnan(mul_tmp)){
+                    --valid_len;
+                    continue;
+                }
+                mul_sum += mul_tmp;
+                x_sum += x_data[i];
+                y_sum += y_data[i];
+            }
+            res = mul_sum - x_sum * y_sum / valid_len;
+        }
+
+        if (bias){
+            return res / valid_len;
+        }
+        else{
+            return res / (valid_len - 1);
+        }
+    }
+
+
+    /**
+     * @brief 两组数的相关系数，忽略 NaN：
+     *        若某组数某处为 NaN，则两组数的该位置都被忽略
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @return 两组数的相关系数
+     */
+    __attribute__((__always_inline__)) inline double
+    corr(const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength)
+    {
+        size_t valid_len = nLength;
+
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d avx_x, avx_x_sum, avx_x_pow2_sum,
+                    avx_y, avx_y_sum, avx_y_pow2_sum,
+                    avx_mul, avx_mul_sum, valid;
+            __m256i mask;
+            double x_sum, y_sum;
+
+            valid_len = 0;
+            avx_mul_sum = avx_y_pow2_sum = avx_x_pow2_sum = avx_y_sum = avx_x_sum = _mm256_setzero_pd();
+            for (index = 0; index != avx_len; index += 4){
+                avx_x = _mm256_loadu_pd(x_data+index);
+                avx_y = _mm256_loadu_pd(y_data+index);
+                avx_mul = _mm256_mul_pd(avx_x, avx_y);
+                valid = valid_mask(avx_mul);
+                valid_len += count_valid(valid);
+                avx_x = _mm256_and_pd(avx_x, valid);
+                avx_y = _mm256_and_pd(avx_y, valid);
+                avx_x_sum = _mm256_add_pd(avx_x_sum, avx_x);
+                avx_y_sum = _mm256_add_pd(avx_y_sum, avx_y);
+                avx_x_pow2_sum = _mm256_fmadd_pd(avx_x, avx_x, avx_x_pow2_sum);
+                avx_y_pow2_sum = _mm256_fmadd_pd(avx_y, avx_y, avx_y_pow2_sum);
+                avx_mul_sum = _mm256_add_pd(avx_mul_sum, _mm256_and_pd(avx_mul, valid));
+            }
+            mask = tail_mask(nLength & 0x3);
+            avx_x = _mm256_maskload_pd(x_data+index, mask);
+            avx_y = _mm256_maskload_pd(y_data+index, mask);
+            avx_mul = _mm256_mul_pd(avx_x, avx_y);
+            valid = _mm256_and_pd(valid_mask(avx_mul), _mm256_castsi256_pd(mask));
+            valid_len += count_valid(valid);
+            avx_x = _mm256_and_pd(avx_x, valid);
+            avx_y = _mm256_and_pd(avx_y, valid);
+            avx_x_sum = _mm256_add_pd(avx_x_sum, avx_x);
+            avx_y_sum = _mm256_add_pd(avx_y_sum, avx_y);
+            avx_x_pow2_sum = _mm256_fmadd_pd(avx_x, avx_x, avx_x_pow2_sum);
+            avx_y_pow2_sum = _mm256_fmadd_pd(avx_y, avx_y, avx_y_pow2_sum);
+            avx_mul_sum = _mm256_add_pd(avx_mul_sum, _mm256_and_pd(avx_mul, valid));
+            x_sum = reduce_add_pd(avx_x_sum);
+            y_sum = reduce_add_pd(avx_y_sum);
+            return (reduce_add_pd(avx_mul_sum) * valid_len - x_sum * y_sum) /
+                    sqrt((reduce_add_pd(avx_x_pow2_sum) * valid_len - x_sum * x_sum) *
+                        (reduce_add_pd(avx_y_pow2_sum) * valid_len - y_sum * y_sum));
+        }
+        else{
+            double x_sum, x_pow2_sum, y_sum, y_pow2_sum, mul_sum, mul_tmp;
+            x_sum = x_pow2_sum = y_sum = y_pow2_sum = mul_sum = 0;
+            for (size_t i = 0; i != nLength; ++i){
+                mul_tmp = x_data[i] * y_data[i];
+                if (isnan(mul_tmp)){
+                    --valid_len;
+                    continue;
+                }
+                mul_sum += mul_tmp;
+                x_sum += x_data[i];
+                y_sum += y_data[i];
+                x_pow2_sum += x_data[i] * x_data[i];
+                y_pow2_sum += y_data[i] * y_data[i];
+            }
+            return (mul_sum * valid_len - x_sum * y_sum) /
+                    sqrt((x_pow2_sum * valid_len - x_sum * x_sum) *
+                        (y_pow2_sum * valid_len - y_sum * y_sum));
+        }
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    skew(const double *data, size_t nLength)
+    {
+        size_t valid_len;
+        double avg = sum_len(data, nLength, &valid_len);
+        avg = avg / valid_len;
+        double up = sub_unifunc_sum(pow3, avx_pow3, data, avg, nLength);
+        double down_tmp = unifunc_sum(pow2, avx_pow2, data, nLength) - avg*avg*valid_len;
+        return up / sqrt(pow3(down_tmp) / valid_len);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    kurt(const double *data, size_t nLength)
+    {
+        size_t valid_len;
+        double avg = sum_len(data, nLength, &valid_len);
+        avg = avg / valid_len;
+        double up = sub_unifunc_sum(pow4, avx_pow4, data, avg, nLength);
+        double down_tmp = unifunc_sum(pow2, avx_pow2, data, nLength) - avg*avg*valid_len;
+        return valid_len * up / (down_tmp * down_tmp);
+    }
+
+
+    /**
+     * @brief return __m256d containing 2^x's
+     * @details
+     * Same rational approximation as FAST_MATH::avx_2pow,
+     * but the reduction x = k + r (0 <= r < 1) is done with _mm256_floor_pd
+     * since AVX2 lacks the variable 64-bit compares the bitwise version relies on;
+     * 2^k is then applied by adding k to the exponent field of 2^r.
+     *
+     * Special Cases & Overflow & Underflow are the same as FAST_MATH::avx_2pow:
+     *      INFINITY, x >= 1024     ->  INFINITY
+     *      -INFINITY, x < -1022    ->  0
+     *      NaN                     ->  NaN
+     */
+    __attribute__((__always_inline__)) inline __m256d
+    avx_2pow(__m256d avx_x){
+        static const __m256i pow_poly_params[7] = {_mm256_set1_epi64x(0x40071547652b82fe),
+                                                    _mm256_set1_epi64x(0x3fbd9303fea2f72e),
+                                                    _mm256_set1_epi64x(0xbf4e50096ddced00),
+                                                    _mm256_set1_epi64x(0x3ee63144f2a26823),
+                                                    _mm256_set1_epi64x(0xbe810f4ee1b45d09),
+                                                    _mm256_set1_epi64x(0x3e1a79b6ef2e5c08),
+                                                    _mm256_set1_epi64x(0xbdb3c3b324a10f23)};
+        __m256d avx_k, avx_r, avx_sum, avx_pow2, avx_tmp, nan_mask, overflow_mask, underflow_mask;
+        __m256i avx_exp;
+
+        nan_mask = _mm256_cmp_pd(avx_x, avx_x, _CMP_UNORD_Q);
+        overflow_mask = _mm256_cmp_pd(avx_x, _mm256_set1_pd(1024), _CMP_GE_OQ);
+        underflow_mask = _mm256_cmp_pd(avx_x, _mm256_set1_pd(-1022), _CMP_LT_OQ);
+        avx_x = _mm256_andnot_pd(_mm256_or_pd(nan_mask, _mm256_or_pd(overflow_mask, underflow_mask)), avx_x);
+
+        avx_k = _mm256_floor_pd(avx_x);
+        avx_r = _mm256_sub_pd(avx_x, avx_k);
+
+        avx_pow2 = _mm256_mul_pd(avx_r, avx_r);
+        avx_sum = _mm256_fmadd_pd(avx_pow2, _mm256_castsi256_pd(pow_poly_params[1]),
+                                            _mm256_castsi256_pd(pow_poly_params[0]));
+        avx_tmp = avx_pow2;
+        #pragma GCC unroll 5
+        for (uint8_t i = 2; i != 7; ++i){
+            avx_tmp = _mm256_mul_pd(avx_tmp, avx_pow2);
+            avx_sum = _mm256_fmadd_pd(avx_tmp, _mm256_castsi256_pd(pow_poly_params[i]), avx_sum);
+        }
+        avx_sum = _mm256_div_pd(_mm256_add_pd(avx_sum, avx_r), _mm256_sub_pd(avx_sum, avx_r));
+
+        // k 在 [-1022, 1023] 内，加到 2^r 的指数位上
+        avx_exp = _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(avx_k)), 52);
+        avx_sum = _mm256_castsi256_pd(_mm256_add_epi64(_mm256_castpd_si256(avx_sum), avx_exp));
+
+        avx_sum = _mm256_blendv_pd(avx_sum, _mm256_set1_pd(INFINITY), overflow_mask);
+        avx_sum = _mm256_andnot_pd(underflow_mask, avx_sum);
+        avx_sum = _mm256_blendv_pd(avx_sum, _mm256_set1_pd(NAN), nan_mask);
+        return avx_sum;
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_2pow(const double *data, size_t nLength, double *out)
+    {
+        __m256d avx_tmp;
+        if (nLength & ~0x3){
+            size_t avx_end = nLength & ~0x3, index;
+            for (index = 0; index != avx_end; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                _mm256_storeu_pd(out+index, avx_2pow(avx_tmp));
+            }
+            __m256i mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            _mm256_maskstore_pd(out+index, mask, avx_2pow(avx_tmp));
+        }
+        else{
+            #pragma GCC ivdep
+            for (size_t i = 0; i < nLength; ++i){
+                out[i] = pow(2, data[i]);
+            }
+        }
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_exp(const double *data, size_t nLength, double *out)
+    {
+        if (nLength & ~0x3){
+            const __m256d log2_e = _mm256_castsi256_pd(_mm256_set1_epi64x(0x3ff71547652b82fe));
+            __m256d avx_tmp;
+            size_t avx_end = nLength & ~0x3, index;
+            for (index = 0; index != avx_end; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                _mm256_storeu_pd(out+index, avx_2pow(_mm256_mul_pd(avx_tmp, log2_e)));
+            }
+            __m256i mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            _mm256_maskstore_pd(out+index, mask, avx_2pow(_mm256_mul_pd(avx_tmp, log2_e)));
+        }
+        else{
+            #pragma GCC ivdep
+            for (size_t i = 0; i < nLength; ++i){
+                out[i] = exp(data[i]);
+            }
+        }
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_npow(double base, const double *data, size_t nLength, double *out)
+    {
+        if (nLength & ~0x3){
+            __m256d log2_base = _mm256_set1_pd(log2(base));
+            __m256d avx_tmp;
+            size_t avx_end = nLength & ~0x3, index;
+            for (index = 0; index != avx_end; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                _mm256_storeu_pd(out+index, avx_2pow(_mm256_mul_pd(avx_tmp, log2_base)));
+            }
+            __m256i mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            _mm256_maskstore_pd(out+index, mask, avx_2pow(_mm256_mul_pd(avx_tmp, log2_base)));
+        }
+        else{
+            #pragma GCC ivdep
+            for (size_t i = 0; i < nLength; ++i){
+                out[i] = pow(base, data[i]);
+            }
+        }
+    }
+
+
+    /**
+     * @brief return __m256d containing log_2(x)'s
+     * @details
+     * Same method and polynomial as FAST_MATH::avx_log2;
+     * the exponent k is converted to double with the 2^52 + 2^51 magic number
+     * since AVX2 has no int64 -> double conversion.
+     *
+     * Special Cases are the same as FAST_MATH::avx_log2:
+     *      INFINITY            ->  INFINITY
+     *      NaN                 ->  NaN
+     *      x = 0, subnormals   ->  -INFINITY
+     *      x < 0               ->  NaN
+     */
+    __attribute__((__always_inline__)) inline __m256d
+    avx_log2(__m256d avx_tmp){
+        static const __m256i log2_poly_params[7] = {_mm256_set1_epi64x(0x40071547652bc40c),
+                                                    _mm256_set1_epi64x(0x3feec709d8c635d6),
+                                                    _mm256_set1_epi64x(0x3fe2776e3a8c7fdf),
+                                                    _mm256_set1_epi64x(0x3fda60ab57139605),
+                                                    _mm256_set1_epi64x(0x3fd49892aaf11053),
+                                                    _mm256_set1_epi64x(0x3fcf99fd730a2573),
+                                                    _mm256_set1_epi64x(0x3fd4360e9afd45df)};
+        __m256d avx_pow2, avx_sum, avx_k, ninf_mask, neg_mask, nan_mask, pinf_mask;
+        __m256i avx_bits, avx_exp;
+
+        avx_bits = _mm256_castpd_si256(avx_tmp);
+        avx_exp = _mm256_and_si256(avx_bits, exp_mask);
+        ninf_mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(avx_exp, _mm256_setzero_si256()));
+        nan_mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(avx_exp, exp_mask));
+        neg_mask = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_setzero_si256(), avx_bits));
+        pinf_mask = _mm256_and_pd(nan_mask, _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+                                _mm256_and_si256(avx_bits, _mm256_or_si256(frac_mask, sign_mask)),
+                                _mm256_setzero_si256())));
+        avx_exp = _mm256_sub_epi64(_mm256_srli_epi64(avx_exp, 52), exp_sub);
+        avx_k = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(avx_exp, cvt_magic)),
+                            _mm256_castsi256_pd(cvt_magic));
+
+        avx_tmp = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(avx_bits, frac_mask), exp_set));
+        avx_tmp = _mm256_div_pd(_mm256_sub_pd(avx_tmp, _mm256_set1_pd(1)),
+                                _mm256_add_pd(avx_tmp, _mm256_set1_pd(1)));
+        avx_pow2 = _mm256_mul_pd(avx_tmp, avx_tmp);
+        avx_sum = _mm256_mul_pd(avx_tmp, _mm256_castsi256_pd(log2_poly_params[0]));
+        #pragma GCC unroll 6
+        for (uint8_t j = 1; j != 7; ++j){
+            avx_tmp = _mm256_mul_pd(avx_pow2, avx_tmp);
+            avx_sum = _mm256_fmadd_pd(_mm256_castsi256_pd(log2_poly_params[j]), avx_tmp, avx_sum);
+        }
+        avx_sum = _mm256_add_pd(avx_sum, avx_k);
+        avx_sum = _mm256_blendv_pd(avx_sum, _mm256_set1_pd(-INFINITY), ninf_mask);
+        avx_sum = _mm256_blendv_pd(avx_sum, _mm256_set1_pd(NAN), _mm256_or_pd(neg_mask, nan_mask));
+        avx_sum = _mm256_blendv_pd(avx_sum, _mm256_set1_pd(INFINITY), pinf_mask);
+        return avx_sum;
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_log2(const double * __restrict__ data, size_t nLength, double * __restrict__ out)
+    {
+        __m256d avx_tmp;
+        if (nLength & ~0x3){
+            size_t avx_end = nLength & ~0x3, index;
+            for (index = 0; index != avx_end; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                _mm256_storeu_pd(out+index, avx_log2(avx_tmp));
+            }
+            __m256i mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            _mm256_maskstore_pd(out+index, mask, avx_log2(avx_tmp));
+        }
+        else{
+            #pragma GCC ivdep
+            for (size_t i = 0; i < nLength; ++i){
+                out[i] = log2(data[i]);
+            }
+        }
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_log(const double * __restrict__ data, size_t nLength, double * __restrict__ out)
+    {
+        const __m256d log2_e = _mm256_castsi256_pd(_mm256_set1_epi64x(0x3ff71547652b82fe));
+        __m256d avx_tmp;
+        if (nLength & ~0x3){
+            size_t avx_end = nLength & ~0x3, index;
+            for (index = 0; index != avx_end; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                _mm256_storeu_pd(out+index, _mm256_div_pd(avx_log2(avx_tmp), log2_e));
+            }
+            __m256i mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            _mm256_maskstore_pd(out+index, mask, _mm256_div_pd(avx_log2(avx_tmp), log2_e));
+        }
+        else{
+            #pragma GCC ivdep
+            for (size_t i = 0; i < nLength; ++i){
+                out[i] = log(data[i]);
+            }
+        }
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_log10(const double * __restrict__ data, size_t nLength, double * __restrict__ out)
+    {
+        const __m256d log2_10 = _mm256_castsi256_pd(_mm256_set1_epi64x(0x400a934f0979a371));
+        __m256d avx_tmp;
+        if (nLength & ~0x3){
+            size_t avx_end = nLength & ~0x3, index;
+            for (index = 0; index != avx_end; index += 4){
+                avx_tmp = _mm256_loadu_pd(data+index);
+                _mm256_storeu_pd(out+index, _mm256_div_pd(avx_log2(avx_tmp), log2_10));
+            }
+            __m256i mask = tail_mask(nLength & 0x3);
+            avx_tmp = _mm256_maskload_pd(data+index, mask);
+            _mm256_maskstore_pd(out+index, mask, _mm256_div_pd(avx_log2(avx_tmp), log2_10));
+        }
+        else{
+            #pragma GCC ivdep
+            for (size_t i = 0; i < nLength; ++i){
+                out[i] = log10(data[i]);
+            }
+        }
+    }
+
+
+    /**
+     * @brief caculate the exponential moving average,
+     *        same 4-lane decomposition as the 8-lane FAST_MATH::ema
+     * @param data double list
+     * @param n the position (index) where the weighted calculation starts
+     * @param k current position (index)
+     * @return the exponential moving average at current position
+     */
+    __attribute__((__always_inline__)) inline double
+    ema(const double *data, size_t n, size_t k)
+    {
+        double beta = 2 / static_cast<double>(n+1);
+        double beta_1sub = 1 - beta;
+        double res = mean(data, n);
+        size_t compu_len = k - n;
+
+        if (compu_len & ~0xf){
+            double beta_1sub_pows[5];
+            beta_1sub_pows[4] = 1; beta_1sub_pows[3] = beta_1sub;
+            #pragma GCC unroll 4
+            for (uint8_t i = 3; i != 0; --i){
+                beta_1sub_pows[i-1] = beta_1sub_pows[i] * beta_1sub;
+            }
+
+            __m256d avx_tmp, avx_res = _mm256_set1_pd(res/4);
+            __m256d avx_beta_1sub = _mm256_set1_pd(beta_1sub_pows[0]),
+            avx_beta = _mm256_mul_pd(_mm256_set1_pd(beta), _mm256_loadu_pd(&beta_1sub_pows[1]));
+
+            const double *avx_begin = data + n;
+            size_t avx_len = compu_len & ~0x3, index;
+
+            for (index = 0; index != avx_len; index += 4){
+                avx_tmp = _mm256_mul_pd(_mm256_loadu_pd(avx_begin+index), avx_beta);
+                avx_res = _mm256_fmadd_pd(avx_res, avx_beta_1sub, avx_tmp);
+            }
+            size_t compu_len_mod = compu_len & 0x3;
+            avx_tmp = _mm256_mul_pd(_mm256_maskload_pd(avx_begin+index, tail_mask(compu_len_mod)), avx_beta);
+            avx_res = _mm256_fmadd_pd(avx_res, avx_beta_1sub, avx_tmp);
+            return reduce_add_pd(avx_res) / beta_1sub_pows[compu_len_mod];
+        }
+        else{
+            for (size_t i = n; i != k; ++i){
+                res = beta_1sub * res + beta * data[i];
+            }
+            return res;
+        }
+    }
+
+
+    /**
+     * @brief calculate the beta parameter for univariate linear regression
+     * @param x_data independent variable
+     * @param y_data dependent variable
+     * @param nLength length of x_data and y_data
+     * @return parameter beta
+     */
+    __attribute__((__always_inline__)) inline double
+    beta(const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength)
+    {
+        size_t valid_len = nLength;
+
+        if (nLength & ~0x3){
+            size_t avx_len = nLength & ~0x3, index;
+            __m256d avx_x, avx_x_sum, avx_x_pow2_sum,
+                    avx_y, avx_y_sum, avx_mul, avx_mul_sum, valid;
+            __m256i mask;
+            double x_sum, y_sum;
+
+            valid_len = 0;
+            avx_mul_sum = avx_x_pow2_sum = avx_y_sum = avx_x_sum = _mm256_setzero_pd();
+            for (index = 0; index != avx_len; index += 4){
+                avx_x = _mm256_loadu_pd(x_data+index);
+                avx_y = _mm256_loadu_pd(y_data+index);
+                avx_mul = _mm256_mul_pd(avx_x, avx_y);
+                valid = valid_mask(avx_mul);
+                valid_len += count_valid(valid);
+                avx_x = _mm256_and_pd(avx_x, valid);
+                avx_x_sum = _mm256_add_pd(avx_x_sum, avx_x);
+                avx_y_sum = _mm256_add_pd(avx_y_sum, _mm256_and_pd(avx_y, valid));
+                avx_x_pow2_sum = _mm256_fmadd_pd(avx_x, avx_x, avx_x_pow2_sum);
+                avx_mul_sum = _mm256_add_pd(avx_mul_sum, _mm256_and_pd(avx_mul, valid));
+            }
+            mask = tail_mask(nLength & 0x3);
+            avx_x = _mm256_maskload_pd(x_data+index, mask);
+            avx_y = _mm256_maskload_pd(y_data+index, mask);
+            avx_mul = _mm256_mul_pd(avx_x, avx_y);
+            valid = _mm256_and_pd(valid_mask(avx_mul), _mm256_castsi256_pd(mask));
+            valid_len += count_valid(valid);
+            avx_x = _mm256_and_pd(avx_x, valid);
+            avx_x_sum = _mm256_add_pd(avx_x_sum, avx_x);
+            avx_y_sum = _mm256_add_pd(avx_y_sum, _mm256_and_pd(avx_y, valid));
+            avx_x_pow2_sum = _mm256_fmadd_pd(avx_x, avx_x, avx_x_pow2_sum);
+            avx_mul_sum = _mm256_add_pd(avx_mul_sum, _mm256_and_pd(avx_mul, valid));
+            x_sum = reduce_add_pd(avx_x_sum);
+            y_sum = reduce_add_pd(avx_y_sum);
+            return (reduce_add_pd(avx_mul_sum) * valid_len - x_sum * y_sum) /
+                    (reduce_add_pd(avx_x_pow2_sum) * valid_len - x_sum * x_sum);
+        }
+        else{
+            double x_sum, x_pow2_sum, y_sum, mul_sum, mul_tmp;
+            x_sum = x_pow2_sum = y_sum = mul_sum = 0;
+            for (size_t i = 0; i != nLength; ++i){
+                mul_tmp = x_data[i] * y_data[i];
+                if (isnan(mul_tmp)){
+                    --valid_len;
+                    continue;
+                }
+                mul_sum += mul_tmp;
+                x_sum += x_data[i];
+                y_sum += y_data[i];
+                x_pow2_sum += x_data[i] * x_data[i];
+            }
+            return (mul_sum * valid_len - x_sum * y_sum) /
+                    (x_pow2_sum * valid_len - x_sum * x_sum);
+        }
+    }
+
+
+};
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef FAST_MATH_BATCH_H
+#define FAST_MATH_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+#include <immintrin.h>
+#include <math.h>
+#include "fast_math.h"
+
+
+// FAST_MATH 的批量统计：对许多个品种同时计算同一个统计量。
+// 数据为 nRows × nCols 的矩阵，按行连续存放：data[t * nCols + j] 为第 j 个品种在第 t 个时刻的值，
+// 即每一行是同一时刻所有品种的截面，最近 window 个时刻就是从 data + (nRows - window) * nCols 开始的连续一段。
+// 每个 __m512d 装 8 个品种在同一时刻的值，沿时间方向累加，
+// 每次同时处理 BATCH_GROUP 个 __m512d（32 个品种），使累加链互相独立，窗口很短时也能跑满 FMA。
+// 输出数组 out 长度为 nCols，out[j] 为第 j 个品种的结果
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512cd,avx512bw,avx512vl,fma,popcnt")
+
+namespace FAST_MATH
+{
+    static const size_t BATCH_GROUP = 4;
+
+
+    /**
+     * @brief 从第 col 列起的 BATCH_GROUP 个 __m512d 各自的 mask，超出 nCols 的 lane 不在 mask 中
+     */
+    __attribute__((__always_inline__)) inline void
+    batch_masks(size_t col, size_t nCols, __mmask8 *mask)
+    {
+        #pragma GCC unroll 4
+        for (size_t k = 0; k != BATCH_GROUP; ++k){
+            size_t begin = col + 8 * k;
+            size_t remain = nCols > begin ? nCols - begin : 0;
+            mask[k] = remain >= 8 ? 0xff : (1 << remain) - 1;
+        }
+    }
+
+
+    /**
+     * @brief 每个品种的平均值，NaN 的处理由 NAN_POLICY 决定（默认忽略 NaN）
+     * @param data nRows × nCols 的矩阵，按行连续存放
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param out 输出数组，长度为 nCols
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    __attribute__((__always_inline__)) inline void
+    batch_mean(const double * __restrict__ data, size_t nRows, size_t nCols, double * __restrict__ out)
+    {
+        const __m512d avx_one = _mm512_set1_pd(1);
+        __mmask8 mask[BATCH_GROUP], valid;
+
+        for (size_t col = 0; col < nCols; col += 8 * BATCH_GROUP){
+            batch_masks(col, nCols, mask);
+            __m512d avx_n[BATCH_GROUP], avx_sum[BATCH_GROUP], avx_tmp;
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                avx_n[k] = avx_sum[k] = _mm512_setzero_pd();
+            }
+
+            for (size_t t = 0; t != nRows; ++t){
+                const double *row = data + t * nCols + col;
+                #pragma GCC unroll 4
+                for (size_t k = 0; k != BATCH_GROUP; ++k){
+                    avx_tmp = _mm512_maskz_loadu_pd(mask[k], row + 8 * k);
+                    valid = NAN_POLICY::valid_mask(avx_tmp, mask[k]);
+                    avx_sum[k] = _mm512_mask_add_pd(avx_sum[k], valid, avx_sum[k], avx_tmp);
+                    avx_n[k] = _mm512_mask_add_pd(avx_n[k], valid, avx_n[k], avx_one);
+                }
+            }
+
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                _mm512_mask_storeu_pd(out + col + 8 * k, mask[k], _mm512_div_pd(avx_sum[k], avx_n[k]));
+            }
+        }
+    }
+
+
+    /**
+     * @brief 每个品种的方差，NaN 的处理由 NAN_POLICY 决定（默认忽略 NaN）；
+     *        窗口一般很短、数据在缓存中，先求均值再求离差平方和（两遍），与 var 一样不受数值偏移的影响
+     * @param data nRows × nCols 的矩阵，按行连续存放
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param bias 有偏估计（除以 n）还是无偏估计（除以 n-1）
+     * @param out 输出数组，长度为 nCols
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    __attribute__((__always_inline__)) inline void
+    batch_var(const double * __restrict__ data, size_t nRows, size_t nCols, bool bias, double * __restrict__ out)
+    {
+        const __m512d avx_one = _mm512_set1_pd(1), avx_zero = _mm512_setzero_pd(), avx_nan = _mm512_set1_pd(NAN),
+                    avx_ddof = _mm512_set1_pd(bias ? 0 : 1);
+        __mmask8 mask[BATCH_GROUP], valid;
+
+        for (size_t col = 0; col < nCols; col += 8 * BATCH_GROUP){
+            batch_masks(col, nCols, mask);
+            __m512d avx_n[BATCH_GROUP], avx_mean[BATCH_GROUP], avx_m2[BATCH_GROUP], avx_tmp;
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                avx_n[k] = avx_mean[k] = avx_m2[k] = avx_zero;
+            }
+
+            for (size_t t = 0; t != nRows; ++t){
+                const double *row = data + t * nCols + col;
+                #pragma GCC unroll 4
+                for (size_t k = 0; k != BATCH_GROUP; ++k){
+                    avx_tmp = _mm512_maskz_loadu_pd(mask[k], row + 8 * k);
+                    valid = NAN_POLICY::valid_mask(avx_tmp, mask[k]);
+                    avx_mean[k] = _mm512_mask_add_pd(avx_mean[k], valid, avx_mean[k], avx_tmp);
+                    avx_n[k] = _mm512_mask_add_pd(avx_n[k], valid, avx_n[k], avx_one);
+                }
+            }
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                avx_mean[k] = _mm512_div_pd(avx_mean[k], avx_n[k]);
+            }
+
+            for (size_t t = 0; t != nRows; ++t){
+                const double *row = data + t * nCols + col;
+                #pragma GCC unroll 4
+                for (size_t k = 0; k != BATCH_GROUP; ++k){
+                    avx_tmp = _mm512_maskz_loadu_pd(mask[k], row + 8 * k);
+                    valid = NAN_POLICY::valid_mask(avx_tmp, mask[k]);
+                    avx_tmp = _mm512_maskz_sub_pd(valid, avx_tmp, avx_mean[k]);
+                    avx_m2[k] = _mm512_fmadd_pd(avx_tmp, avx_tmp, avx_m2[k]);
+                }
+            }
+
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                avx_tmp = _mm512_div_pd(avx_m2[k], _mm512_sub_pd(avx_n[k], avx_ddof));
+                avx_tmp = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(avx_n[k], avx_zero, _CMP_EQ_OQ), avx_tmp, avx_nan);
+                _mm512_mask_storeu_pd(out + col + 8 * k, mask[k], avx_tmp);
+            }
+        }
+    }
+
+
+    /**
+     * @brief 每个品种的标准差，见 batch_var
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    __attribute__((__always_inline__)) inline void
+    batch_std(const double * __restrict__ data, size_t nRows, size_t nCols, bool bias, double * __restrict__ out)
+    {
+        batch_var<NAN_POLICY>(data, nRows, nCols, bias, out);
+        for (size_t col = 0; col < nCols; col += 8){
+            __mmask8 mask = nCols - col >= 8 ? 0xff : (1 << (nCols - col)) - 1;
+            _mm512_mask_storeu_pd(out + col, mask, _mm512_sqrt_pd(_mm512_maskz_loadu_pd(mask, out + col)));
+        }
+    }
+
+
+    /**
+     * @brief 每个品种的一元线性回归 beta（y 对 x），NaN 的处理由 NAN_POLICY 决定（默认忽略 NaN）：
+     *        若某组数某处为 NaN，则两组数的该位置都被忽略
+     * @param x_data 自变量，nRows × nCols 的矩阵，按行连续存放
+     * @param y_data 因变量，与 x_data 形状相同
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param out 输出数组，长度为 nCols
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    __attribute__((__always_inline__)) inline void
+    batch_beta(const double * __restrict__ x_data, const double * __restrict__ y_data,
+                size_t nRows, size_t nCols, double * __restrict__ out)
+    {
+        const __m512d avx_one = _mm512_set1_pd(1), avx_zero = _mm512_setzero_pd();
+        __mmask8 mask[BATCH_GROUP], valid;
+
+        for (size_t col = 0; col < nCols; col += 8 * BATCH_GROUP){
+            batch_masks(col, nCols, mask);
+            __m512d avx_n[BATCH_GROUP], avx_x_mean[BATCH_GROUP], avx_y_mean[BATCH_GROUP],
+                    avx_sxx[BATCH_GROUP], avx_sxy[BATCH_GROUP], avx_x, avx_y;
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                avx_n[k] = avx_x_mean[k] = avx_y_mean[k] = avx_sxx[k] = avx_sxy[k] = avx_zero;
+            }
+
+            for (size_t t = 0; t != nRows; ++t){
+                const double *x_row = x_data + t * nCols + col, *y_row = y_data + t * nCols + col;
+                #pragma GCC unroll 4
+                for (size_t k = 0; k != BATCH_GROUP; ++k){
+                    avx_x = _mm512_maskz_loadu_pd(mask[k], x_row + 8 * k);
+                    avx_y = _mm512_maskz_loadu_pd(mask[k], y_row + 8 * k);
+                    valid = NAN_POLICY::valid_mask(_mm512_mul_pd(avx_x, avx_y), mask[k]);
+                    avx_x_mean[k] = _mm512_mask_add_pd(avx_x_mean[k], valid, avx_x_mean[k], avx_x);
+                    avx_y_mean[k] = _mm512_mask_add_pd(avx_y_mean[k], valid, avx_y_mean[k], avx_y);
+                    avx_n[k] = _mm512_mask_add_pd(avx_n[k], valid, avx_n[k], avx_one);
+                }
+            }
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                avx_x_mean[k] = _mm512_div_pd(avx_x_mean[k], avx_n[k]);
+                avx_y_mean[k] = _mm512_div_pd(avx_y_mean[k], avx_n[k]);
+            }
+
+            for (size_t t = 0; t != nRows; ++t){
+                const double *x_row = x_data + t * nCols + col, *y_row = y_data + t * nCols + col;
+                #pragma GCC unroll 4
+                for (size_t k = 0; k != BATCH_GROUP; ++k){
+                    avx_x = _mm512_maskz_loadu_pd(mask[k], x_row + 8 * k);
+                    avx_y = _mm512_maskz_loadu_pd(mask[k], y_row + 8 * k);
+                    valid = NAN_POLICY::valid_mask(_mm512_mul_pd(avx_x, avx_y), mask[k]);
+                    avx_x = _mm512_maskz_sub_pd(valid, avx_x, avx_x_mean[k]);
+                    avx_y = _mm512_maskz_sub_pd(valid, avx_y, avx_y_mean[k]);
+                    avx_sxx[k] = _mm512_fmadd_pd(avx_x, avx_x, avx_sxx[k]);
+                    avx_sxy[k] = _mm512_fmadd_pd(avx_x, avx_y, avx_sxy[k]);
+                }
+            }
+
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                _mm512_mask_storeu_pd(out + col + 8 * k, mask[k], _mm512_div_pd(avx_sxy[k], avx_sxx[k]));
+            }
+        }
+    }
+
+
+    /**
+     * @brief 每个品种在最后一个时刻的指数移动平均，与 vec_ema(adjust = false) 相同：
+     *        alpha = 2 / (span + 1)，从第一个非 NaN 的数开始递推，NaN 不更新；全为 NaN 时为 NaN
+     * @param data nRows × nCols 的矩阵，按行连续存放
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param span 平均的跨度，与 ema 中的 n 相同
+     * @param out 输出数组，长度为 nCols
+     */
+    __attribute__((__always_inline__)) inline void
+    batch_ema(const double * __restrict__ data, size_t nRows, size_t nCols, double span, double * __restrict__ out)
+    {
+        double beta = 2 / (span + 1);
+        const __m512d avx_beta = _mm512_set1_pd(beta), avx_beta_1sub = _mm512_set1_pd(1 - beta),
+                    avx_nan = _mm512_set1_pd(NAN);
+        __mmask8 mask[BATCH_GROUP], valid, first;
+
+        for (size_t col = 0; col < nCols; col += 8 * BATCH_GROUP){
+            batch_masks(col, nCols, mask);
+            __m512d avx_res[BATCH_GROUP], avx_tmp;
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                avx_res[k] = avx_nan;
+            }
+
+            for (size_t t = 0; t != nRows; ++t){
+                const double *row = data + t * nCols + col;
+                #pragma GCC unroll 4
+                for (size_t k = 0; k != BATCH_GROUP; ++k){
+                    avx_tmp = _mm512_maskz_loadu_pd(mask[k], row + 8 * k);
+                    valid = avx_valid_mask(avx_tmp) & mask[k];
+                    // 还没有值的 lane 直接取第一个非 NaN 的数
+                    first = _mm512_mask_cmp_pd_mask(valid, avx_res[k], avx_res[k], _CMP_UNORD_Q);
+                    avx_res[k] = _mm512_mask_fmadd_pd(avx_res[k], valid, avx_beta_1sub, _mm512_mul_pd(avx_tmp, avx_beta));
+                    avx_res[k] = _mm512_mask_mov_pd(avx_res[k], first, avx_tmp);
+                }
+            }
+
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != BATCH_GROUP; ++k){
+                _mm512_mask_storeu_pd(out + col + 8 * k, mask[k], avx_res[k]);
+            }
+        }
+    }
+};
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef FAST_MATH_CROSS_H
+#define FAST_MATH_CROSS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+#include <immintrin.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "fast_math.h"
+
+
+// FAST_MATH 的截面运算：在每个时刻对所有品种做标准化，结果原地写回。
+// 数据与 fast_math_batch.h 相同，为 nRows × nCols 的矩阵，按行连续存放：data[t * nCols + j] 为第 j 个品种在第 t 个时刻的值，
+// 每一行即一个截面，直接用 calc_moments、rank 等 AVX-512 函数处理，不需要先取出一列。
+// 可选的 group 为长度 nCols 的分组（行业）编号，给出时在每组内部分别计算；编号为负的品种结果为 NaN。
+// NaN 不参与计算，结果仍为 NaN
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512cd,avx512bw,avx512vl,fma,popcnt")
+
+namespace FAST_MATH
+{
+    /**
+     * @brief 按分组编号把列重新排列：order[offset[g], offset[g+1]) 为第 g 组的列，组内保持原来的顺序；
+     *        编号为负的列排在 order[offset[nGroups], nCols)。
+     *        编号可以是稀疏的（如行业代码 801010），出现过的编号按从小到大压缩为 0 ~ nGroups-1，
+     *        内存与每行的开销只与 nCols 有关
+     */
+    struct CS_GROUPS
+    {
+        size_t nCols;
+        size_t nGroups;
+        size_t *order;
+        size_t *offset;
+
+        CS_GROUPS(const int *group, size_t nCols) : nCols(nCols), nGroups(0)
+        {
+            order = new size_t[nCols + 1];
+            size_t nValid = 0, nInvalid = 0;
+            for (size_t j = 0; j != nCols; ++j){
+                if (group[j] >= 0){
+                    order[nValid++] = j;
+                }
+            }
+            for (size_t j = 0; j != nCols; ++j){
+                if (group[j] < 0){
+                    order[nValid + nInvalid++] = j;
+                }
+            }
+            // 按 (编号, 列号) 排序，相同编号的列连在一起
+            std::sort(order, order + nValid, [=](size_t a, size_t b){
+                return group[a] < group[b] || (group[a] == group[b] && a < b);
+            });
+
+            offset = new size_t[nValid + 1];
+            for (size_t i = 0; i != nValid; ++i){
+                if (i == 0 || group[order[i]] != group[order[i-1]]){
+                    offset[nGroups++] = i;
+                }
+            }
+            offset[nGroups] = nValid;
+        }
+
+        ~CS_GROUPS()
+        {
+            delete[] order;
+            delete[] offset;
+        }
+
+        CS_GROUPS(const CS_GROUPS &) = delete;
+        CS_GROUPS &operator=(const CS_GROUPS &) = delete;
+
+        /**
+         * @brief 把一行按组取到 buffer 中，buffer[offset[g], offset[g+1]) 为第 g 组的值
+         */
+        __attribute__((__always_inline__)) inline void
+        gather(const double * __restrict__ row, double * __restrict__ buffer) const
+        {
+            size_t n = offset[nGroups];
+            __mmask8 mask;
+            for (size_t i = 0; i < n; i += 8){
+                mask = n - i >= 8 ? 0xff : (1 << (n - i)) - 1;
+                __m512i avx_index = _mm512_maskz_loadu_epi64(mask, order + i);
+                _mm512_mask_storeu_pd(buffer + i, mask, _mm512_mask_i64gather_pd(_mm512_setzero_pd(), mask, avx_index, row, 8));
+            }
+        }
+
+        /**
+         * @brief 把 gather 取出并处理过的 buffer 写回一行，不属于任何组的品种写 NaN
+         */
+        __attribute__((__always_inline__)) inline void
+        scatter(const double * __restrict__ buffer, double * __restrict__ row) const
+        {
+            size_t n = offset[nGroups];
+            __mmask8 mask;
+            for (size_t i = 0; i < n; i += 8){
+                mask = n - i >= 8 ? 0xff : (1 << (n - i)) - 1;
+                __m512i avx_index = _mm512_maskz_loadu_epi64(mask, order + i);
+                _mm512_mask_i64scatter_pd(row, mask, avx_index, _mm512_maskz_loadu_pd(mask, buffer + i), 8);
+            }
+            for (size_t i = n; i != nCols; ++i){
+                row[order[i]] = NAN;
+            }
+        }
+    };
+
+
+    /**
+     * @brief 对每一行（group 不为 NULL 时为每一行的每一组）调用 func(x, n)，x 为连续的 n 个值，原地修改
+     * @param buffer 长度至少为 nCols 的临时数组，group 为 NULL 时不使用
+     */
+    template <typename FUNC>
+    __attribute__((__always_inline__)) inline void
+    cs_apply(double *data, size_t nRows, size_t nCols, const int *group, double *buffer, FUNC func)
+    {
+        if (group == NULL){
+            for (size_t t = 0; t != nRows; ++t){
+                func(data + t * nCols, nCols);
+            }
+            return;
+        }
+
+        CS_GROUPS groups(group, nCols);
+        for (size_t t = 0; t != nRows; ++t){
+            double *row = data + t * nCols;
+            groups.gather(row, buffer);
+            for (size_t g = 0; g != groups.nGroups; ++g){
+                if (groups.offset[g+1] != groups.offset[g]){
+                    func(buffer + groups.offset[g], groups.offset[g+1] - groups.offset[g]);
+                }
+            }
+            groups.scatter(buffer, row);
+        }
+    }
+
+
+    /**
+     * @brief x = (x - shift) * scale，NaN 保持为 NaN
+     */
+    __attribute__((__always_inline__)) inline void
+    cs_affine(double *x, size_t nLength, double shift, double scale)
+    {
+        const __m512d avx_shift = _mm512_set1_pd(shift), avx_scale = _mm512_set1_pd(scale);
+        __mmask8 mask;
+        for (size_t i = 0; i < nLength; i += 8){
+            mask = nLength - i >= 8 ? 0xff : (1 << (nLength - i)) - 1;
+            __m512d avx_tmp = _mm512_maskz_loadu_pd(mask, x + i);
+            _mm512_mask_storeu_pd(x + i, mask, _mm512_mul_pd(_mm512_sub_pd(avx_tmp, avx_shift), avx_scale));
+        }
+    }
+
+
+    /**
+     * @brief 截面去均值：每个值减去同一时刻（同一组）的平均值，用于行业中性化
+     * @param data nRows × nCols 的矩阵，按行连续存放，结果原地写回
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param group 长度为 nCols 的分组编号，为 NULL 时不分组
+     */
+    __attribute__((__always_inline__)) inline void
+    cs_demean(double *data, size_t nRows, size_t nCols, const int *group = NULL)
+    {
+        double *buffer = group ? new double[nCols + 1] : NULL;
+        cs_apply(data, nRows, nCols, group, buffer, [](double *x, size_t n){
+            cs_affine(x, n, mean(x, n), 1);
+        });
+        delete[] buffer;
+    }
+
+
+    /**
+     * @brief 截面 z-score：(x - mean) / std，std 为无偏估计；有效值少于 2 个或 std 为 0 时结果为 NaN
+     * @param data nRows × nCols 的矩阵，按行连续存放，结果原地写回
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param group 长度为 nCols 的分组编号，为 NULL 时不分组
+     */
+    __attribute__((__always_inline__)) inline void
+    cs_zscore(double *data, size_t nRows, size_t nCols, const int *group = NULL)
+    {
+        double *buffer = group ? new double[nCols + 1] : NULL;
+        cs_apply(data, nRows, nCols, group, buffer, [](double *x, size_t n){
+            moments m = calc_moments(x, n);
+            double sd = sqrt(moments_var(m, false));
+            cs_affine(x, n, m.mean, sd > 0 ? 1 / sd : NAN);
+        });
+        delete[] buffer;
+    }
+
+
+    /**
+     * @brief 截面缩尾：把值限制在 [mean - k * std, mean + k * std] 内，std 为无偏估计；
+     *        有效值少于 2 个时不做处理
+     * @param data nRows × nCols 的矩阵，按行连续存放，结果原地写回
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param k 标准差的倍数
+     * @param group 长度为 nCols 的分组编号，为 NULL 时不分组
+     */
+    __attribute__((__always_inline__)) inline void
+    cs_winsorize(double *data, size_t nRows, size_t nCols, double k, const int *group = NULL)
+    {
+        double *buffer = group ? new double[nCols + 1] : NULL;
+        cs_apply(data, nRows, nCols, group, buffer, [=](double *x, size_t n){
+            moments m = calc_moments(x, n);
+            double width = k * sqrt(moments_var(m, false));
+            // 上下界为 NaN 或 x 为 NaN 时 min/max 返回第二个参数，即 x 不变
+            const __m512d avx_lower = _mm512_set1_pd(m.mean - width), avx_upper = _mm512_set1_pd(m.mean + width);
+            __mmask8 mask;
+            for (size_t i = 0; i < n; i += 8){
+                mask = n - i >= 8 ? 0xff : (1 << (n - i)) - 1;
+                __m512d avx_tmp = _mm512_maskz_loadu_pd(mask, x + i);
+                avx_tmp = _mm512_max_pd(avx_lower, _mm512_min_pd(avx_upper, avx_tmp));
+                _mm512_mask_storeu_pd(x + i, mask, avx_tmp);
+            }
+        });
+        delete[] buffer;
+    }
+
+
+    /**
+     * @brief 截面排名：相等的值取平均排名（从 1 开始），pct 为 true 时除以有效值的个数，得到 (0, 1] 内的百分位
+     * @param data nRows × nCols 的矩阵，按行连续存放，结果原地写回
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param pct 是否转为百分位
+     * @param group 长度为 nCols 的分组编号，为 NULL 时不分组
+     */
+    __attribute__((__always_inline__)) inline void
+    cs_rank(double *data, size_t nRows, size_t nCols, bool pct = true, const int *group = NULL)
+    {
+        double *buffer = group ? new double[nCols + 1] : NULL;
+        double *rank_out = new double[nCols + 1];
+        double *key_buffer = new double[nCols + 1];
+        size_t *index_buffer = new size_t[nCols + 1];
+
+        cs_apply(data, nRows, nCols, group, buffer, [=](double *x, size_t n){
+            size_t count = n;
+            if (pct){
+                sum_len(x, n, &count);
+            }
+            rank(x, n, rank_out, RANK_AVERAGE, RANK_NAN_KEEP, key_buffer, index_buffer);
+            cs_affine(rank_out, n, 0, pct ? 1.0 / count : 1);
+            memcpy(x, rank_out, sizeof(double) * n);
+        });
+
+        delete[] buffer;
+        delete[] rank_out;
+        delete[] key_buffer;
+        delete[] index_buffer;
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
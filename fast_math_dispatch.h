@@ -0,0 +1,695 @@
+#ifndef FAST_MATH_DISPATCH_H
+#define FAST_MATH_DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simple_math.h"
+#include "fast_math_avx2.h"
+#include "fast_math.h"
+
+
+// 运行时指令集分发：
+// fast_math.h / fast_math_avx2.h 中的函数都带有 target 属性，
+// 因此本文件可以在不加 -march=native 的情况下编译，生成的程序在首次调用时
+// 通过 CPUID 检测一次 CPU 支持的指令集，之后所有调用都经由同一张函数指针表
+// 转发到 AVX-512 (FAST_MATH)、AVX2 + FMA (FAST_MATH_AVX2) 或标量 (SIMPLE_MATH) 实现。
+// 可以通过环境变量 FAST_MATH_ISA=avx512|avx2|scalar 强制降级，便于在同一台机器上对比各档实现
+namespace FAST_MATH_DISPATCH
+{
+    typedef double (*UNI_FUNC)(double);
+    typedef double (*BIN_FUNC)(double, double);
+    typedef FAST_MATH_AVX2::AVX_UNI_FUNC AVX2_UNI_FUNC;
+    typedef FAST_MATH_AVX2::AVX_BIN_FUNC AVX2_BIN_FUNC;
+    typedef FAST_MATH::AVX_UNI_FUNC AVX512_UNI_FUNC;
+    typedef FAST_MATH::AVX_BIN_FUNC AVX512_BIN_FUNC;
+
+
+    enum ISA_LEVEL
+    {
+        ISA_SCALAR = 0,
+        ISA_AVX2 = 1,
+        ISA_AVX512 = 2
+    };
+
+
+    /**
+     * @brief 各档实现共用的函数指针表，
+     *        unifunc / binfunc 系列同时接收各档的向量函数，由对应的实现取用其中之一
+     */
+    struct KERNEL_TABLE
+    {
+        double (*sum)(const double *, size_t);
+        double (*unifunc_sum)(UNI_FUNC, AVX512_UNI_FUNC, AVX2_UNI_FUNC, const double *, size_t);
+        double (*sub_unifunc_sum)(UNI_FUNC, AVX512_UNI_FUNC, AVX2_UNI_FUNC, const double *, double, size_t);
+        double (*binfunc_sum)(BIN_FUNC, AVX512_BIN_FUNC, AVX2_BIN_FUNC, const double *, const double *, size_t);
+        double (*sub_binfunc_sum)(BIN_FUNC, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                                const double *, double, const double *, double, size_t);
+        double (*sum_len)(const double *, size_t, size_t *);
+        double (*unifunc_sum_len)(UNI_FUNC, AVX512_UNI_FUNC, AVX2_UNI_FUNC, const double *, size_t, size_t *);
+        double (*sub_unifunc_sum_len)(UNI_FUNC, AVX512_UNI_FUNC, AVX2_UNI_FUNC,
+                                    const double *, double, size_t, size_t *);
+        double (*binfunc_sum_len)(BIN_FUNC, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                                const double *, const double *, size_t, size_t *);
+        double (*sub_binfunc_sum_len)(BIN_FUNC, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                                    const double *, double, const double *, double, size_t, size_t *);
+        double (*mean)(const double *, size_t);
+        double (*unifunc_mean)(UNI_FUNC, AVX512_UNI_FUNC, AVX2_UNI_FUNC, const double *, size_t);
+        double (*sub_unifunc_mean)(UNI_FUNC, AVX512_UNI_FUNC, AVX2_UNI_FUNC, const double *, double, size_t);
+        double (*binfunc_mean)(BIN_FUNC, AVX512_BIN_FUNC, AVX2_BIN_FUNC, const double *, const double *, size_t);
+        double (*sub_binfunc_mean)(BIN_FUNC, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                                const double *, double, const double *, double, size_t);
+        double (*min)(const double *, size_t);
+        size_t (*imin)(const double *, size_t);
+        double (*max)(const double *, size_t);
+        size_t (*imax)(const double *, size_t);
+        double (*var)(const double *, size_t, bool);
+        double (*std)(const double *, size_t, bool);
+        double (*dot)(const double *, const double *, size_t);
+        double (*covar)(const double *, const double *, size_t, bool);
+        double (*corr)(const double *, const double *, size_t);
+        double (*skew)(const double *, size_t);
+        double (*kurt)(const double *, size_t);
+        void (*vec_2pow)(const double *, size_t, double *);
+        void (*vec_exp)(const double *, size_t, double *);
+        void (*vec_npow)(double, const double *, size_t, double *);
+        void (*vec_log2)(const double *, size_t, double *);
+        void (*vec_log)(const double *, size_t, double *);
+        void (*vec_log10)(const double *, size_t, double *);
+        double (*ema)(const double *, size_t, size_t);
+        double (*beta)(const double *, const double *, size_t);
+    };
+
+
+    // 统一签名的 unifunc / binfunc 包装：
+    // 固定签名的函数直接取 FAST_MATH / FAST_MATH_AVX2 / SIMPLE_MATH 中的函数地址，
+    // 取地址时编译器会按各自的 target 属性生成一份非内联的实现
+    #pragma GCC push_options
+    #pragma GCC target("avx512f,avx512dq,avx512cd,avx512bw,avx512vl,fma,popcnt")
+
+    namespace AVX512_IMPL
+    {
+        inline double
+        unifunc_sum(UNI_FUNC func, AVX512_UNI_FUNC avx_func, AVX2_UNI_FUNC, const double *data, size_t nLength)
+        {
+            return FAST_MATH::unifunc_sum(func, avx_func, data, nLength);
+        }
+
+        inline double
+        sub_unifunc_sum(UNI_FUNC func, AVX512_UNI_FUNC avx_func, AVX2_UNI_FUNC,
+                        const double *data, double sub, size_t nLength)
+        {
+            return FAST_MATH::sub_unifunc_sum(func, avx_func, data, sub, nLength);
+        }
+
+        inline double
+        binfunc_sum(BIN_FUNC func, AVX512_BIN_FUNC avx_func, AVX2_BIN_FUNC,
+                    const double *x_data, const double *y_data, size_t nLength)
+        {
+            return FAST_MATH::binfunc_sum(func, avx_func, x_data, y_data, nLength);
+        }
+
+        inline double
+        sub_binfunc_sum(BIN_FUNC func, AVX512_BIN_FUNC avx_func, AVX2_BIN_FUNC,
+                        const double *x_data, double x_sub, const double *y_data, double y_sub, size_t nLength)
+        {
+            return FAST_MATH::sub_binfunc_sum(func, avx_func, x_data, x_sub, y_data, y_sub, nLength);
+        }
+
+        inline double
+        unifunc_sum_len(UNI_FUNC func, AVX512_UNI_FUNC avx_func, AVX2_UNI_FUNC,
+                        const double *data, size_t nLength, size_t *valid_len)
+        {
+            return FAST_MATH::unifunc_sum_len(func, avx_func, data, nLength, valid_len);
+        }
+
+        inline double
+        sub_unifunc_sum_len(UNI_FUNC func, AVX512_UNI_FUNC avx_func, AVX2_UNI_FUNC,
+                            const double *data, double sub, size_t nLength, size_t *valid_len)
+        {
+            return FAST_MATH::sub_unifunc_sum_len(func, avx_func, data, sub, nLength, valid_len);
+        }
+
+        inline double
+        binfunc_sum_len(BIN_FUNC func, AVX512_BIN_FUNC avx_func, AVX2_BIN_FUNC,
+                        const double *x_data, const double *y_data, size_t nLength, size_t *valid_len)
+        {
+            return FAST_MATH::binfunc_sum_len(func, avx_func, x_data, y_data, nLength, valid_len);
+        }
+
+        inline double
+        sub_binfunc_sum_len(BIN_FUNC func, AVX512_BIN_FUNC avx_func, AVX2_BIN_FUNC,
+                            const double *x_data, double x_sub, const double *y_data, double y_sub,
+                            size_t nLength, size_t *valid_len)
+        {
+            return FAST_MATH::sub_binfunc_sum_len(func, avx_func, x_data, x_sub, y_data, y_sub, nLength, valid_len);
+        }
+
+        inline double
+        unifunc_mean(UNI_FUNC func, AVX512_UNI_FUNC avx_func, AVX2_UNI_FUNC, const double *data, size_t nLength)
+        {
+            return FAST_MATH::unifunc_mean(func, avx_func, data, nLength);
+        }
+
+        inline double
+        sub_unifunc_mean(UNI_FUNC func, AVX512_UNI_FUNC avx_func, AVX2_UNI_FUNC,
+                        const double *data, double sub, size_t nLength)
+        {
+            return FAST_MATH::sub_unifunc_mean(func, avx_func, data, sub, nLength);
+        }
+
+        inline double
+        binfunc_mean(BIN_FUNC func, AVX512_BIN_FUNC avx_func, AVX2_BIN_FUNC,
+                    const double *x_data, const double *y_data, size_t nLength)
+        {
+            return FAST_MATH::binfunc_mean(func, avx_func, x_data, y_data, nLength);
+        }
+
+        inline double
+        sub_binfunc_mean(BIN_FUNC func, AVX512_BIN_FUNC avx_func, AVX2_BIN_FUNC,
+                        const double *x_data, double x_sub, const double *y_data, double y_sub, size_t nLength)
+        {
+            return FAST_MATH::sub_binfunc_mean(func, avx_func, x_data, x_sub, y_data, y_sub, nLength);
+        }
+    };
+
+    #pragma GCC pop_options
+
+
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma,popcnt")
+
+    namespace AVX2_IMPL
+    {
+        inline double
+        unifunc_sum(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC avx_func, const double *data, size_t nLength)
+        {
+            return FAST_MATH_AVX2::unifunc_sum(func, avx_func, data, nLength);
+        }
+
+        inline double
+        sub_unifunc_sum(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC avx_func,
+                        const double *data, double sub, size_t nLength)
+        {
+            return FAST_MATH_AVX2::sub_unifunc_sum(func, avx_func, data, sub, nLength);
+        }
+
+        inline double
+        binfunc_sum(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC avx_func,
+                    const double *x_data, const double *y_data, size_t nLength)
+        {
+            return FAST_MATH_AVX2::binfunc_sum(func, avx_func, x_data, y_data, nLength);
+        }
+
+        inline double
+        sub_binfunc_sum(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC avx_func,
+                        const double *x_data, double x_sub, const double *y_data, double y_sub, size_t nLength)
+        {
+            return FAST_MATH_AVX2::sub_binfunc_sum(func, avx_func, x_data, x_sub, y_data, y_sub, nLength);
+        }
+
+        inline double
+        unifunc_sum_len(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC avx_func,
+                        const double *data, size_t nLength, size_t *valid_len)
+        {
+            return FAST_MATH_AVX2::unifunc_sum_len(func, avx_func, data, nLength, valid_len);
+        }
+
+        inline double
+        sub_unifunc_sum_len(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC avx_func,
+                            const double *data, double sub, size_t nLength, size_t *valid_len)
+        {
+            return FAST_MATH_AVX2::sub_unifunc_sum_len(func, avx_func, data, sub, nLength, valid_len);
+        }
+
+        inline double
+        binfunc_sum_len(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC avx_func,
+                        const double *x_data, const double *y_data, size_t nLength, size_t *valid_len)
+        {
+            return FAST_MATH_AVX2::binfunc_sum_len(func, avx_func, x_data, y_data, nLength, valid_len);
+        }
+
+        inline double
+        sub_binfunc_sum_len(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC avx_func,
+                            const double *x_data, double x_sub, const double *y_data, double y_sub,
+                            size_t nLength, size_t *valid_len)
+        {
+            return FAST_MATH_AVX2::sub_binfunc_sum_len(func, avx_func, x_data, x_sub, y_data, y_sub, nLength, valid_len);
+        }
+
+        inline double
+        unifunc_mean(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC avx_func, const double *data, size_t nLength)
+        {
+            return FAST_MATH_AVX2::unifunc_mean(func, avx_func, data, nLength);
+        }
+
+        inline double
+        sub_unifunc_mean(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC avx_func,
+                        const double *data, double sub, size_t nLength)
+        {
+            return FAST_MATH_AVX2::sub_unifunc_mean(func, avx_func, data, sub, nLength);
+        }
+
+        inline double
+        binfunc_mean(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC avx_func,
+                    const double *x_data, const double *y_data, size_t nLength)
+        {
+            return FAST_MATH_AVX2::binfunc_mean(func, avx_func, x_data, y_data, nLength);
+        }
+
+        inline double
+        sub_binfunc_mean(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC avx_func,
+                        const double *x_data, double x_sub, const double *y_data, double y_sub, size_t nLength)
+        {
+            return FAST_MATH_AVX2::sub_binfunc_mean(func, avx_func, x_data, x_sub, y_data, y_sub, nLength);
+        }
+    };
+
+    #pragma GCC pop_options
+
+
+    namespace SCALAR_IMPL
+    {
+        inline double
+        unifunc_sum(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC, const double *data, size_t nLength)
+        {
+            return SIMPLE_MATH::unifunc_sum(func, data, nLength);
+        }
+
+        inline double
+        sub_unifunc_sum(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC,
+                        const double *data, double sub, size_t nLength)
+        {
+            return SIMPLE_MATH::sub_unifunc_sum(func, data, sub, nLength);
+        }
+
+        inline double
+        binfunc_sum(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                    const double *x_data, const double *y_data, size_t nLength)
+        {
+            return SIMPLE_MATH::binfunc_sum(func, x_data, y_data, nLength);
+        }
+
+        inline double
+        sub_binfunc_sum(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                        const double *x_data, double x_sub, const double *y_data, double y_sub, size_t nLength)
+        {
+            return SIMPLE_MATH::sub_binfunc_sum(func, x_data, x_sub, y_data, y_sub, nLength);
+        }
+
+        inline double
+        unifunc_sum_len(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC,
+                        const double *data, size_t nLength, size_t *valid_len)
+        {
+            return SIMPLE_MATH::unifunc_sum_len(func, data, nLength, valid_len);
+        }
+
+        inline double
+        sub_unifunc_sum_len(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC,
+                            const double *data, double sub, size_t nLength, size_t *valid_len)
+        {
+            return SIMPLE_MATH::sub_unifunc_sum_len(func, data, sub, nLength, valid_len);
+        }
+
+        inline double
+        binfunc_sum_len(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                        const double *x_data, const double *y_data, size_t nLength, size_t *valid_len)
+        {
+            return SIMPLE_MATH::binfunc_sum_len(func, x_data, y_data, nLength, valid_len);
+        }
+
+        inline double
+        sub_binfunc_sum_len(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                            const double *x_data, double x_sub, const double *y_data, double y_sub,
+                            size_t nLength, size_t *valid_len)
+        {
+            return SIMPLE_MATH::sub_binfunc_sum_len(func, x_data, x_sub, y_data, y_sub, nLength, valid_len);
+        }
+
+        inline double
+        unifunc_mean(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC, const double *data, size_t nLength)
+        {
+            return SIMPLE_MATH::unifunc_mean(func, data, nLength);
+        }
+
+        inline double
+        sub_unifunc_mean(UNI_FUNC func, AVX512_UNI_FUNC, AVX2_UNI_FUNC,
+                        const double *data, double sub, size_t nLength)
+        {
+            return SIMPLE_MATH::sub_unifunc_mean(func, data, sub, nLength);
+        }
+
+        inline double
+        binfunc_mean(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                    const double *x_data, const double *y_data, size_t nLength)
+        {
+            return SIMPLE_MATH::binfunc_mean(func, x_data, y_data, nLength);
+        }
+
+        inline double
+        sub_binfunc_mean(BIN_FUNC func, AVX512_BIN_FUNC, AVX2_BIN_FUNC,
+                        const double *x_data, double x_sub, const double *y_data, double y_sub, size_t nLength)
+        {
+            return SIMPLE_MATH::sub_binfunc_mean(func, x_data, x_sub, y_data, y_sub, nLength);
+        }
+    };
+
+
+    #define FAST_MATH_DISPATCH_TABLE(NS, IMPL) \
+        { \
+            NS::sum, IMPL::unifunc_sum, IMPL::sub_unifunc_sum, IMPL::binfunc_sum, IMPL::sub_binfunc_sum, \
+            NS::sum_len, IMPL::unifunc_sum_len, IMPL::sub_unifunc_sum_len, \
+            IMPL::binfunc_sum_len, IMPL::sub_binfunc_sum_len, \
+            NS::mean, IMPL::unifunc_mean, IMPL::sub_unifunc_mean, IMPL::binfunc_mean, IMPL::sub_binfunc_mean, \
+            NS::min, NS::imin, NS::max, NS::imax, \
+            NS::var, NS::std, NS::dot, NS::covar, NS::corr, NS::skew, NS::kurt, \
+            NS::vec_2pow, NS::vec_exp, NS::vec_npow, NS::vec_log2, NS::vec_log, NS::vec_log10, \
+            NS::ema, NS::beta \
+        }
+
+    static const KERNEL_TABLE avx512_table = FAST_MATH_DISPATCH_TABLE(FAST_MATH, AVX512_IMPL);
+    static const KERNEL_TABLE avx2_table = FAST_MATH_DISPATCH_TABLE(FAST_MATH_AVX2, AVX2_IMPL);
+    static const KERNEL_TABLE scalar_table = FAST_MATH_DISPATCH_TABLE(SIMPLE_MATH, SCALAR_IMPL);
+
+    #undef FAST_MATH_DISPATCH_TABLE
+
+
+    /**
+     * @brief 通过 CPUID 检测 CPU 支持的最高指令集档位，
+     *        环境变量 FAST_MATH_ISA 可以把档位调低（不能调高）
+     */
+    inline ISA_LEVEL
+    detect_isa()
+    {
+        ISA_LEVEL level = ISA_SCALAR;
+
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+            __builtin_cpu_supports("avx512cd") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512vl")){
+            level = ISA_AVX512;
+        }
+        else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+            level = ISA_AVX2;
+        }
+
+        const char *env = getenv("FAST_MATH_ISA");
+        if (env != NULL){
+            if (strcmp(env, "scalar") == 0){
+                level = ISA_SCALAR;
+            }
+            else if (strcmp(env, "avx2") == 0 && level > ISA_AVX2){
+                level = ISA_AVX2;
+            }
+        }
+        return level;
+    }
+
+
+    /**
+     * @brief 当前使用的指令集档位，只在首次调用时检测
+     */
+    inline ISA_LEVEL
+    isa()
+    {
+        static const ISA_LEVEL level = detect_isa();
+        return level;
+    }
+
+
+    __attribute__((__always_inline__)) inline const KERNEL_TABLE &
+    kernels()
+    {
+        static const KERNEL_TABLE *table = isa() == ISA_AVX512 ? &avx512_table :
+                                            isa() == ISA_AVX2 ? &avx2_table : &scalar_table;
+        return *table;
+    }
+
+
+    inline const char *
+    isa_name()
+    {
+        static const char *names[3] = {"scalar", "avx2", "avx512"};
+        return names[isa()];
+    }
+
+
+    // 以下接口与 FAST_MATH 中的同名函数语义一致（忽略 NaN 等），
+    // unifunc / binfunc 系列需要同时给出标量、AVX-512 和 AVX2 三种版本的函数
+
+    __attribute__((__always_inline__)) inline double
+    sum(const double *data, size_t nLength)
+    {
+        return kernels().sum(data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    unifunc_sum(UNI_FUNC func, AVX512_UNI_FUNC avx512_func, AVX2_UNI_FUNC avx2_func,
+                const double *data, size_t nLength)
+    {
+        return kernels().unifunc_sum(func, avx512_func, avx2_func, data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sub_unifunc_sum(UNI_FUNC func, AVX512_UNI_FUNC avx512_func, AVX2_UNI_FUNC avx2_func,
+                    const double *data, double sub, size_t nLength)
+    {
+        return kernels().sub_unifunc_sum(func, avx512_func, avx2_func, data, sub, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    binfunc_sum(BIN_FUNC func, AVX512_BIN_FUNC avx512_func, AVX2_BIN_FUNC avx2_func,
+                const double *x_data, const double *y_data, size_t nLength)
+    {
+        return kernels().binfunc_sum(func, avx512_func, avx2_func, x_data, y_data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sub_binfunc_sum(BIN_FUNC func, AVX512_BIN_FUNC avx512_func, AVX2_BIN_FUNC avx2_func,
+                    const double *x_data, double x_sub, const double *y_data, double y_sub, size_t nLength)
+    {
+        return kernels().sub_binfunc_sum(func, avx512_func, avx2_func, x_data, x_sub, y_data, y_sub, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sum_len(const double *data, size_t nLength, size_t *valid_len)
+    {
+        return kernels().sum_len(data, nLength, valid_len);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    unifunc_sum_len(UNI_FUNC func, AVX512_UNI_FUNC avx512_func, AVX2_UNI_FUNC avx2_func,
+                    const double *data, size_t nLength, size_t *valid_len)
+    {
+        return kernels().unifunc_sum_len(func, avx512_func, avx2_func, data, nLength, valid_len);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sub_unifunc_sum_len(UNI_FUNC func, AVX512_UNI_FUNC avx512_func, AVX2_UNI_FUNC avx2_func,
+                        const double *data, double sub, size_t nLength, size_t *valid_len)
+    {
+        return kernels().sub_unifunc_sum_len(func, avx512_func, avx2_func, data, sub, nLength, valid_len);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    binfunc_sum_len(BIN_FUNC func, AVX512_BIN_FUNC avx512_func, AVX2_BIN_FUNC avx2_func,
+                    const double *x_data, const double *y_data, size_t nLength, size_t *valid_len)
+    {
+        return kernels().binfunc_sum_len(func, avx512_func, avx2_func, x_data, y_data, nLength, valid_len);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sub_binfunc_sum_len(BIN_FUNC func, AVX512_BIN_FUNC avx512_func, AVX2_BIN_FUNC avx2_func,
+                        const double *x_data, double x_sub, const double *y_data, double y_sub,
+                        size_t nLength, size_t *valid_len)
+    {
+        return kernels().sub_binfunc_sum_len(func, avx512_func, avx2_func,
+                                            x_data, x_sub, y_data, y_sub, nLength, valid_len);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    mean(const double *data, size_t nLength)
+    {
+        return kernels().mean(data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    unifunc_mean(UNI_FUNC func, AVX512_UNI_FUNC avx512_func, AVX2_UNI_FUNC avx2_func,
+                const double *data, size_t nLength)
+    {
+        return kernels().unifunc_mean(func, avx512_func, avx2_func, data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sub_unifunc_mean(UNI_FUNC func, AVX512_UNI_FUNC avx512_func, AVX2_UNI_FUNC avx2_func,
+                    const double *data, double sub, size_t nLength)
+    {
+        return kernels().sub_unifunc_mean(func, avx512_func, avx2_func, data, sub, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    binfunc_mean(BIN_FUNC func, AVX512_BIN_FUNC avx512_func, AVX2_BIN_FUNC avx2_func,
+                const double *x_data, const double *y_data, size_t nLength)
+    {
+        return kernels().binfunc_mean(func, avx512_func, avx2_func, x_data, y_data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    sub_binfunc_mean(BIN_FUNC func, AVX512_BIN_FUNC avx512_func, AVX2_BIN_FUNC avx2_func,
+                    const double *x_data, double x_sub, const double *y_data, double y_sub, size_t nLength)
+    {
+        return kernels().sub_binfunc_mean(func, avx512_func, avx2_func, x_data, x_sub, y_data, y_sub, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    min(const double *data, size_t nLength)
+    {
+        return kernels().min(data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline size_t
+    imin(const double *data, size_t nLength)
+    {
+        return kernels().imin(data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    max(const double *data, size_t nLength)
+    {
+        return kernels().max(data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline size_t
+    imax(const double *data, size_t nLength)
+    {
+        return kernels().imax(data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    var(const double *data, size_t nLength, bool bias)
+    {
+        return kernels().var(data, nLength, bias);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    std(const double *data, size_t nLength, bool bias)
+    {
+        return kernels().std(data, nLength, bias);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    dot(const double *x_data, const double *y_data, size_t nLength)
+    {
+        return kernels().dot(x_data, y_data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    covar(const double *x_data, const double *y_data, size_t nLength, bool bias)
+    {
+        return kernels().covar(x_data, y_data, nLength, bias);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    corr(const double *x_data, const double *y_data, size_t nLength)
+    {
+        return kernels().corr(x_data, y_data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    skew(const double *data, size_t nLength)
+    {
+        return kernels().skew(data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    kurt(const double *data, size_t nLength)
+    {
+        return kernels().kurt(data, nLength);
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_2pow(const double *data, size_t nLength, double *out)
+    {
+        kernels().vec_2pow(data, nLength, out);
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_exp(const double *data, size_t nLength, double *out)
+    {
+        kernels().vec_exp(data, nLength, out);
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_npow(double base, const double *data, size_t nLength, double *out)
+    {
+        kernels().vec_npow(base, data, nLength, out);
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_log2(const double *data, size_t nLength, double *out)
+    {
+        kernels().vec_log2(data, nLength, out);
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_log(const double *data, size_t nLength, double *out)
+    {
+        kernels().vec_log(data, nLength, out);
+    }
+
+
+    __attribute__((__always_inline__)) inline void
+    vec_log10(const double *data, size_t nLength, double *out)
+    {
+        kernels().vec_log10(data, nLength, out);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    ema(const double *data, size_t n, size_t k)
+    {
+        return kernels().ema(data, n, k);
+    }
+
+
+    __attribute__((__always_inline__)) inline double
+    beta(const double *x_data, const double *y_data, size_t nLength)
+    {
+        return kernels().beta(x_data, y_data, nLength);
+    }
+
+
+};
+
+#endif
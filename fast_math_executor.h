@@ -0,0 +1,302 @@
+#ifndef FAST_MATH_EXECUTOR_H
+#define FAST_MATH_EXECUTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <x86intrin.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include "fast_math_numa.h"
+
+
+// FAST_MATH 的任务调度：一批互不依赖、耗时差别很大的计算（例如对长短不一的序列分别调用 ema / beta / corr / vec_log），
+// 由 TASK_EXECUTOR 的工作线程用 work stealing 执行：
+// 任务按预估耗时从大到小轮流分到各线程的双端队列，线程从自己队列的头部取（先做大任务），
+// 自己的队列空了就从其他线程队列的尾部偷（偷小任务，收尾时各线程结束的时间更接近）。
+// 工作线程可以绑定到指定的核或 NUMA 节点；每个任务记录所在线程、开始时刻与耗费的 tsc 周期
+namespace FAST_MATH
+{
+    /**
+     * @brief 一个任务的执行记录，begin 为相对于整批开始时刻的 tsc
+     */
+    struct task_stats
+    {
+        size_t worker;
+        uint64_t begin;
+        uint64_t cycles;
+        bool stolen;
+    };
+
+
+    /**
+     * @brief 一个工作线程在一批任务中的汇总：任务数、偷到的任务数、执行任务的 tsc 周期与从开始到结束的 tsc 周期
+     */
+    struct worker_stats
+    {
+        size_t tasks;
+        size_t steals;
+        uint64_t busy;
+        uint64_t wall;
+    };
+
+
+    /**
+     * @brief 一批任务：add(func, cost) 加入一个无参数的可调用对象，cost 为预估耗时（例如序列长度），只用于初始分配；
+     *        TASK_EXECUTOR::run 之后 stats[i] 为第 i 个任务的执行记录，workers 为各工作线程的汇总
+     */
+    struct TASK_BATCH
+    {
+        std::vector<std::function<void()>> funcs;
+        std::vector<double> costs;
+        std::vector<task_stats> stats;
+        std::vector<worker_stats> workers;
+
+        template <typename FUNC>
+        size_t add(FUNC func, double cost = 1)
+        {
+            funcs.emplace_back(func);
+            costs.push_back(cost);
+            return funcs.size() - 1;
+        }
+
+        size_t size() const
+        {
+            return funcs.size();
+        }
+
+        void clear()
+        {
+            funcs.clear();
+            costs.clear();
+            stats.clear();
+            workers.clear();
+        }
+
+        /**
+         * @brief 打印各工作线程的汇总与耗时最多的 top 个任务
+         */
+        void print_stats(size_t top = 10) const
+        {
+            uint64_t wall = 0;
+            for (const worker_stats &w : workers){
+                wall = w.wall > wall ? w.wall : wall;
+            }
+            for (size_t i = 0; i != workers.size(); ++i){
+                printf("worker %zu: %zu tasks (%zu stolen), busy %lu / %lu tsc (%.1f%%)\n", i, workers[i].tasks,
+                    workers[i].steals, workers[i].busy, wall, wall ? 100.0 * workers[i].busy / wall : 0.0);
+            }
+            std::vector<size_t> order(stats.size());
+            for (size_t i = 0; i != order.size(); ++i){
+                order[i] = i;
+            }
+            top = top < order.size() ? top : order.size();
+            std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                [this](size_t a, size_t b){ return stats[a].cycles > stats[b].cycles; });
+            for (size_t i = 0; i != top; ++i){
+                const task_stats &s = stats[order[i]];
+                printf("task %zu: worker %zu%s, begin %lu, %lu tsc\n", order[i], s.worker,
+                    s.stolen ? " (stolen)" : "", s.begin, s.cycles);
+            }
+        }
+    };
+
+
+    /**
+     * @brief 把第 i 个工作线程绑定到第 i 个可用的 CPU（超过 CPU 数时循环）
+     */
+    inline std::vector<std::vector<int>>
+    affinity_by_core(size_t nThreads)
+    {
+        std::vector<int> cpus = available_cpus();
+        std::vector<std::vector<int>> res(nThreads);
+        for (size_t i = 0; i != nThreads && !cpus.empty(); ++i){
+            res[i].push_back(cpus[i % cpus.size()]);
+        }
+        return res;
+    }
+
+
+    /**
+     * @brief 把第 i 个工作线程绑定到第 i % numa_node_count() 个有 CPU 的 NUMA 节点（见 numa_nodes）的所有 CPU 上
+     */
+    inline std::vector<std::vector<int>>
+    affinity_by_numa_node(size_t nThreads)
+    {
+        std::vector<int> nodes = numa_nodes();
+        std::vector<std::vector<int>> res(nThreads);
+        for (size_t i = 0; i != nThreads; ++i){
+            res[i] = numa_node_cpus(nodes[i % nodes.size()]);
+        }
+        return res;
+    }
+
+
+    /**
+     * @brief work stealing 的任务调度器，见文件开头的说明。run 一次执行一批任务，执行完才返回；
+     *        调用 run 的线程只等待，不执行任务
+     */
+    struct TASK_EXECUTOR
+    {
+        // 每个工作线程的队列，按 cache line 对齐，避免不同线程的锁互相干扰
+        struct alignas(64) QUEUE
+        {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        std::vector<std::thread> workers;
+        std::vector<QUEUE> queues;
+        std::mutex run_mutex, mutex;
+        std::condition_variable wake, finished;
+        TASK_BATCH *batch;
+        uint64_t batch_begin;
+        size_t generation, reported;
+        bool stop;
+
+        /**
+         * @param nThreads 工作线程数，为 0 时取 CPU 核数
+         * @param affinity affinity[i] 为第 i 个工作线程可以使用的 CPU，为空时不绑定，见 affinity_by_core / affinity_by_numa_node
+         */
+        explicit TASK_EXECUTOR(size_t nThreads = 0, const std::vector<std::vector<int>> &affinity = {})
+            : queues(nThreads ? nThreads : (std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1)),
+            batch(NULL), batch_begin(0), generation(0), reported(0), stop(false)
+        {
+            for (size_t i = 0; i != queues.size(); ++i){
+                workers.emplace_back([this, i]{ work(i); });
+                if (i < affinity.size()){
+                    pin_thread(workers.back().native_handle(), affinity[i]);
+                }
+            }
+        }
+
+        ~TASK_EXECUTOR()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for (std::thread &worker : workers){
+                worker.join();
+            }
+        }
+
+        TASK_EXECUTOR(const TASK_EXECUTOR &) = delete;
+        TASK_EXECUTOR &operator=(const TASK_EXECUTOR &) = delete;
+
+        size_t size() const
+        {
+            return workers.size();
+        }
+
+        /**
+         * @brief 执行一批任务，填写 batch.stats 与 batch.workers
+         */
+        void run(TASK_BATCH &tasks)
+        {
+            std::lock_guard<std::mutex> run_lock(run_mutex);
+            size_t n = tasks.size(), nWorkers = workers.size();
+
+            // 按预估耗时从大到小轮流分配
+            std::vector<size_t> order(n);
+            for (size_t i = 0; i != n; ++i){
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(),
+                [&tasks](size_t a, size_t b){ return tasks.costs[a] > tasks.costs[b]; });
+            for (size_t i = 0; i != n; ++i){
+                queues[i % nWorkers].tasks.push_back(order[i]);
+            }
+            tasks.stats.assign(n, task_stats());
+            tasks.workers.assign(nWorkers, worker_stats());
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch = &tasks;
+                batch_begin = __rdtsc();
+                reported = 0;
+                ++generation;
+            }
+            wake.notify_all();
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this]{ return reported == workers.size(); });
+            batch = NULL;
+        }
+
+    private:
+        /**
+         * @brief 取一个任务：先从自己队列的头部取，再依次从其他线程队列的尾部偷
+         */
+        bool next_task(size_t self, size_t &task, bool &stolen)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queues[self].mutex);
+                if (!queues[self].tasks.empty()){
+                    task = queues[self].tasks.front();
+                    queues[self].tasks.pop_front();
+                    stolen = false;
+                    return true;
+                }
+            }
+            for (size_t k = 1; k != queues.size(); ++k){
+                QUEUE &victim = queues[(self + k) % queues.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty()){
+                    task = victim.tasks.back();
+                    victim.tasks.pop_back();
+                    stolen = true;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void work(size_t self)
+        {
+            size_t seen = 0;
+            for (;;){
+                TASK_BATCH *tasks;
+                uint64_t begin;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]{ return stop || generation != seen; });
+                    if (stop){
+                        return;
+                    }
+                    seen = generation;
+                    tasks = batch;
+                    begin = batch_begin;
+                }
+
+                // 任务不会产生新任务，所有队列都空了即可结束
+                worker_stats summary = {0, 0, 0, 0};
+                size_t task;
+                bool stolen;
+                while (next_task(self, task, stolen)){
+                    uint64_t task_begin = __rdtsc();
+                    tasks->funcs[task]();
+                    uint64_t task_end = __rdtsc();
+                    tasks->stats[task] = task_stats{self, task_begin - begin, task_end - task_begin, stolen};
+                    summary.tasks += 1;
+                    summary.steals += stolen;
+                    summary.busy += task_end - task_begin;
+                    summary.wall = task_end - begin;
+                }
+                tasks->workers[self] = summary;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (++reported == workers.size()){
+                    finished.notify_one();
+                }
+            }
+        }
+    };
+}
+
+#endif
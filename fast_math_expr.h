@@ -0,0 +1,453 @@
+#ifndef FAST_MATH_EXPR_H
+#define FAST_MATH_EXPR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+#include <immintrin.h>
+#include <math.h>
+#include "fast_math.h"
+
+
+// FAST_MATH 的表达式模板：
+// expr(x, n) / expr(y, n)、.log() 等逐元素运算只构造表达式树，不做计算，
+// 直到调用 sum / mean / dot 等归约（或 eval 写出结果）时才在一个 AVX-512 循环里逐 8 个数求值，
+// 因此 mean(log(x/y)) 这样的式子不需要 vec_log 的中间数组，也只读一遍 x、y。
+// 例如：
+//      (FAST_MATH::expr(x, n) / FAST_MATH::expr(y, n)).log().mean()
+//      ((FAST_MATH::expr(x, n) - a) * (FAST_MATH::expr(y, n) - b)).sum()
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512cd,avx512bw,avx512vl,fma,popcnt")
+
+namespace FAST_MATH
+{
+    /**
+     * @brief 表达式中的逐元素运算，每个运算同时提供 double 与 __m512d 两个版本，
+     *        与 POW2 / MUL 等函数对象的写法一致
+     */
+    namespace EXPR_OP
+    {
+        struct ADD
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x, double y) const
+            {
+                return x + y;
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x, __m512d y) const
+            {
+                return _mm512_add_pd(x, y);
+            }
+        };
+
+
+        struct SUB
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x, double y) const
+            {
+                return x - y;
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x, __m512d y) const
+            {
+                return _mm512_sub_pd(x, y);
+            }
+        };
+
+
+        struct DIV
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x, double y) const
+            {
+                return x / y;
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x, __m512d y) const
+            {
+                return _mm512_div_pd(x, y);
+            }
+        };
+
+
+        struct NEG
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x) const
+            {
+                return -x;
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x) const
+            {
+                return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(x),
+                                                            _mm512_set1_epi64(0x8000000000000000)));
+            }
+        };
+
+
+        // exp / log 系列与 vec_exp / vec_log 等函数的算法相同，结果也一致
+        struct EXP2
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x) const
+            {
+                return exp2(x);
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x) const
+            {
+                return avx_2pow(x);
+            }
+        };
+
+
+        struct EXP
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x) const
+            {
+                return exp(x);
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x) const
+            {
+                return avx_2pow(_mm512_mul_pd(x, _mm512_castsi512_pd(_mm512_set1_epi64(0x3ff71547652b82fe))));
+            }
+        };
+
+
+        struct LOG2
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x) const
+            {
+                return log2(x);
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x) const
+            {
+                return avx_log2(x);
+            }
+        };
+
+
+        struct LOG
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x) const
+            {
+                return log(x);
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x) const
+            {
+                return _mm512_mul_pd(avx_log2(x), _mm512_castsi512_pd(_mm512_set1_epi64(0x3fe62e42fefa39ef)));
+            }
+        };
+
+
+        struct LOG10
+        {
+            __attribute__((__always_inline__)) inline double
+            operator()(double x) const
+            {
+                return log10(x);
+            }
+
+            __attribute__((__always_inline__)) inline __m512d
+            operator()(__m512d x) const
+            {
+                return _mm512_mul_pd(avx_log2(x), _mm512_castsi512_pd(_mm512_set1_epi64(0x3fd34413509f79ff)));
+            }
+        };
+    };
+
+
+    /**
+     * @brief 表达式树的叶节点：数组
+     */
+    struct EXPR_ARRAY
+    {
+        const double *data;
+
+        __attribute__((__always_inline__)) inline double
+        eval(size_t index) const
+        {
+            return data[index];
+        }
+
+        __attribute__((__always_inline__)) inline __m512d
+        avx_eval(size_t index, __mmask8 mask) const
+        {
+            return _mm512_maskz_loadu_pd(mask, data+index);
+        }
+    };
+
+
+    /**
+     * @brief 表达式树的叶节点：常数
+     */
+    struct EXPR_CONST
+    {
+        double value;
+
+        __attribute__((__always_inline__)) inline double
+        eval(size_t) const
+        {
+            return value;
+        }
+
+        __attribute__((__always_inline__)) inline __m512d
+        avx_eval(size_t, __mmask8) const
+        {
+            return _mm512_set1_pd(value);
+        }
+    };
+
+
+    template <typename OP, typename NODE>
+    struct EXPR_UNARY
+    {
+        NODE node;
+
+        __attribute__((__always_inline__)) inline double
+        eval(size_t index) const
+        {
+            return OP()(node.eval(index));
+        }
+
+        __attribute__((__always_inline__)) inline __m512d
+        avx_eval(size_t index, __mmask8 mask) const
+        {
+            return OP()(node.avx_eval(index, mask));
+        }
+    };
+
+
+    template <typename OP, typename LEFT, typename RIGHT>
+    struct EXPR_BINARY
+    {
+        LEFT left;
+        RIGHT right;
+
+        __attribute__((__always_inline__)) inline double
+        eval(size_t index) const
+        {
+            return OP()(left.eval(index), right.eval(index));
+        }
+
+        __attribute__((__always_inline__)) inline __m512d
+        avx_eval(size_t index, __mmask8 mask) const
+        {
+            return OP()(left.avx_eval(index, mask), right.avx_eval(index, mask));
+        }
+    };
+
+
+    /**
+     * @brief 惰性求值的表达式，NODE 为表达式树的根节点；
+     *        逐元素运算返回新的 EXPR，归约（sum / mean / dot 等）才真正遍历数组。
+     *        归约与 sum / mean 等函数一样按 NAN_POLICY 处理 NaN，默认忽略结果为 NaN 的位置；
+     *        参与运算的数组长度须相同，以左侧表达式的长度为准
+     */
+    template <typename NODE>
+    struct EXPR
+    {
+        NODE node;
+        size_t nLength;
+
+        template <typename OP>
+        __attribute__((__always_inline__)) inline EXPR<EXPR_UNARY<OP, NODE> >
+        apply() const
+        {
+            EXPR<EXPR_UNARY<OP, NODE> > res = {{node}, nLength};
+            return res;
+        }
+
+        __attribute__((__always_inline__)) inline EXPR<EXPR_UNARY<EXPR_OP::EXP2, NODE> >
+        exp2() const
+        {
+            return apply<EXPR_OP::EXP2>();
+        }
+
+        __attribute__((__always_inline__)) inline EXPR<EXPR_UNARY<EXPR_OP::EXP, NODE> >
+        exp() const
+        {
+            return apply<EXPR_OP::EXP>();
+        }
+
+        __attribute__((__always_inline__)) inline EXPR<EXPR_UNARY<EXPR_OP::LOG2, NODE> >
+        log2() const
+        {
+            return apply<EXPR_OP::LOG2>();
+        }
+
+        __attribute__((__always_inline__)) inline EXPR<EXPR_UNARY<EXPR_OP::LOG, NODE> >
+        log() const
+        {
+            return apply<EXPR_OP::LOG>();
+        }
+
+        __attribute__((__always_inline__)) inline EXPR<EXPR_UNARY<EXPR_OP::LOG10, NODE> >
+        log10() const
+        {
+            return apply<EXPR_OP::LOG10>();
+        }
+
+        __attribute__((__always_inline__)) inline EXPR<EXPR_UNARY<POW2, NODE> >
+        pow2() const
+        {
+            return apply<POW2>();
+        }
+
+        __attribute__((__always_inline__)) inline EXPR<EXPR_UNARY<EXPR_OP::NEG, NODE> >
+        operator-() const
+        {
+            return apply<EXPR_OP::NEG>();
+        }
+
+        /**
+         * @brief 求和，将忽略 NaN 之后的长度存储在 valid_len 中（valid_len 可以为 NULL）
+         */
+        template <typename NAN_POLICY = SKIP_NAN>
+        __attribute__((__always_inline__)) inline double
+        sum_len(size_t *valid_len) const
+        {
+            NODE root = node;
+            size_t count = nLength;
+
+            if (nLength & ~0x7){
+                return reduce_sum<NAN_POLICY>([=](size_t index, __mmask8 mask){
+                    return root.avx_eval(index, mask);
+                }, nLength, valid_len);
+            }
+            else{
+                double res = 0, tmp;
+                for (size_t index = 0; index != nLength; ++index){
+                    tmp = root.eval(index);
+                    if (NAN_POLICY::valid(tmp)){
+                        res += tmp;
+                    }
+                    else{
+                        --count;
+                    }
+                }
+                if (valid_len){
+                    *valid_len = count;
+                }
+                return res;
+            }
+        }
+
+        template <typename NAN_POLICY = SKIP_NAN>
+        __attribute__((__always_inline__)) inline double
+        sum() const
+        {
+            return sum_len<NAN_POLICY>(NULL);
+        }
+
+        template <typename NAN_POLICY = SKIP_NAN>
+        __attribute__((__always_inline__)) inline double
+        mean() const
+        {
+            size_t valid_len;
+            double data_sum = sum_len<NAN_POLICY>(&valid_len);
+            return data_sum / valid_len;
+        }
+
+        /**
+         * @brief 与另一个表达式的点乘，与 FAST_MATH::dot 相同，为乘积的平均
+         */
+        template <typename NAN_POLICY = SKIP_NAN, typename OTHER>
+        __attribute__((__always_inline__)) inline double
+        dot(const EXPR<OTHER> &other) const
+        {
+            EXPR<EXPR_BINARY<MUL, NODE, OTHER> > res = {{node, other.node}, nLength};
+            return res.template mean<NAN_POLICY>();
+        }
+
+        /**
+         * @brief 把表达式的值写入 out，out 的长度须不小于 nLength
+         */
+        __attribute__((__always_inline__)) inline void
+        eval(double *out) const
+        {
+            if (nLength & ~0x7){
+                size_t avx_end = nLength & ~0x7, index;
+                for (index = 0; index != avx_end; index += 8){
+                    _mm512_storeu_pd(out+index, node.avx_eval(index, 0xff));
+                }
+                __mmask8 mask = (1 << (nLength & 0x7)) - 1;
+                _mm512_mask_storeu_pd(out+index, mask, node.avx_eval(index, mask));
+            }
+            else{
+                for (size_t index = 0; index != nLength; ++index){
+                    out[index] = node.eval(index);
+                }
+            }
+        }
+    };
+
+
+    /**
+     * @brief 以数组构造表达式
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @return 表达式
+     */
+    __attribute__((__always_inline__)) inline EXPR<EXPR_ARRAY>
+    expr(const double *data, size_t nLength)
+    {
+        EXPR<EXPR_ARRAY> res = {{data}, nLength};
+        return res;
+    }
+
+
+    // 表达式与表达式、表达式与常数之间的四则运算
+    #define FAST_MATH_EXPR_OPERATOR(op, OP) \
+        template <typename LEFT, typename RIGHT> \
+        __attribute__((__always_inline__)) inline EXPR<EXPR_BINARY<OP, LEFT, RIGHT> > \
+        operator op(const EXPR<LEFT> &left, const EXPR<RIGHT> &right) \
+        { \
+            EXPR<EXPR_BINARY<OP, LEFT, RIGHT> > res = {{left.node, right.node}, left.nLength}; \
+            return res; \
+        } \
+        \
+        template <typename LEFT> \
+        __attribute__((__always_inline__)) inline EXPR<EXPR_BINARY<OP, LEFT, EXPR_CONST> > \
+        operator op(const EXPR<LEFT> &left, double right) \
+        { \
+            EXPR<EXPR_BINARY<OP, LEFT, EXPR_CONST> > res = {{left.node, {right}}, left.nLength}; \
+            return res; \
+        } \
+        \
+        template <typename RIGHT> \
+        __attribute__((__always_inline__)) inline EXPR<EXPR_BINARY<OP, EXPR_CONST, RIGHT> > \
+        operator op(double left, const EXPR<RIGHT> &right) \
+        { \
+            EXPR<EXPR_BINARY<OP, EXPR_CONST, RIGHT> > res = {{{left}, right.node}, right.nLength}; \
+            return res; \
+        }
+
+    FAST_MATH_EXPR_OPERATOR(+, EXPR_OP::ADD)
+    FAST_MATH_EXPR_OPERATOR(-, EXPR_OP::SUB)
+    FAST_MATH_EXPR_OPERATOR(*, MUL)
+    FAST_MATH_EXPR_OPERATOR(/, EXPR_OP::DIV)
+
+    #undef FAST_MATH_EXPR_OPERATOR
+};
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,674 @@
+#ifndef FAST_MATH_MATRIX_H
+#define FAST_MATH_MATRIX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+#include <immintrin.h>
+#include <math.h>
+#include <string.h>
+#include "fast_math.h"
+#include "fast_math_batch.h"
+
+
+// FAST_MATH 的矩阵运算：数据与 fast_math_batch.h 相同，为 nRows × nCols 的矩阵，按行连续存放，
+// data[t * nCols + j] 为第 j 个品种在第 t 个时刻的值。
+// 协方差矩阵即中心化后的 X^T X（SYRK），用分块的 X^T Y 计算：
+// 沿时间方向每次取 MATRIX_KC 行，把 X 打包成 MATRIX_MR 列一组、Y 打包成 MATRIX_NR 列一组的连续小块，
+// 核心循环在寄存器中累加 MATRIX_MR × MATRIX_NR 的结果（24 个 __m512d），每个时刻 4 次 load、6 次 broadcast、24 次 FMA；
+// 每 MATRIX_MC 列的 X 小块常驻 L2，Y 的小块常驻 L1。输出为 nCols × nCols 的矩阵，按行连续存放
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512cd,avx512bw,avx512vl,fma,popcnt")
+
+namespace FAST_MATH
+{
+    static const size_t MATRIX_MR = 6;
+    static const size_t MATRIX_NR = 32;
+    static const size_t MATRIX_KC = 128;
+    static const size_t MATRIX_MC = 120;
+
+
+    /**
+     * @brief 核心循环：c[r * ldc + j] += sum(ap[t * MR + r] * bp[t * NR + j])，只写回前 rows 行、mask 中的列
+     */
+    __attribute__((__always_inline__)) inline void
+    avx_gemm_kernel(const double * __restrict__ ap, const double * __restrict__ bp, size_t kc,
+                    double * __restrict__ c, size_t ldc, size_t rows, const __mmask8 *mask)
+    {
+        __m512d acc[MATRIX_MR][4], b[4], a;
+
+        #pragma GCC unroll 6
+        for (size_t r = 0; r != MATRIX_MR; ++r){
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != 4; ++k){
+                acc[r][k] = _mm512_setzero_pd();
+            }
+        }
+        for (size_t t = 0; t != kc; ++t){
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != 4; ++k){
+                b[k] = _mm512_loadu_pd(bp + 8 * k);
+            }
+            #pragma GCC unroll 6
+            for (size_t r = 0; r != MATRIX_MR; ++r){
+                a = _mm512_set1_pd(ap[r]);
+                #pragma GCC unroll 4
+                for (size_t k = 0; k != 4; ++k){
+                    acc[r][k] = _mm512_fmadd_pd(a, b[k], acc[r][k]);
+                }
+            }
+            ap += MATRIX_MR;
+            bp += MATRIX_NR;
+        }
+        for (size_t r = 0; r != rows; ++r){
+            #pragma GCC unroll 4
+            for (size_t k = 0; k != 4; ++k){
+                double *dst = c + r * ldc + 8 * k;
+                _mm512_mask_storeu_pd(dst, mask[k], _mm512_add_pd(_mm512_maskz_loadu_pd(mask[k], dst), acc[r][k]));
+            }
+        }
+    }
+
+
+    /**
+     * @brief out = a_func(A)^T b_func(B)，A 为 nRows × a_cols 的矩阵，B 为 nRows × b_cols 的矩阵，都按行连续存放。
+     *        a_func / b_func 形如 (__m512d x, size_t row, size_t col, __mmask8 mask) -> __m512d，
+     *        对第 row 行第 col 列起的 8 个值做变换，在打包时调用，不需要先把变换后的矩阵写出来。
+     *        symmetric 为 true 时（A 与 B、a_func 与 b_func 都相同）只计算上三角，再复制到下三角
+     * @param out 输出数组，a_cols × b_cols
+     */
+    template <typename A_FUNC, typename B_FUNC>
+    inline void
+    avx_gemm_tn(const double *a_data, size_t a_cols, const double *b_data, size_t b_cols, size_t nRows,
+                A_FUNC a_func, B_FUNC b_func, bool symmetric, double *out)
+    {
+        size_t a_blocks = (a_cols + MATRIX_MR - 1) / MATRIX_MR, b_blocks = (b_cols + MATRIX_NR - 1) / MATRIX_NR;
+        double *a_pack = new double[a_blocks * MATRIX_MR * MATRIX_KC + 8];
+        double *b_pack = new double[b_blocks * MATRIX_NR * MATRIX_KC];
+        __mmask8 *b_mask = new __mmask8[b_blocks * 4];
+
+        for (size_t i = 0; i != b_blocks * 4; ++i){
+            size_t remain = b_cols > 8 * i ? b_cols - 8 * i : 0;
+            b_mask[i] = remain >= 8 ? 0xff : (1 << remain) - 1;
+        }
+        memset(out, 0, sizeof(double) * a_cols * b_cols);
+
+        for (size_t kk = 0; kk < nRows; kk += MATRIX_KC){
+            size_t kc = nRows - kk < MATRIX_KC ? nRows - kk : MATRIX_KC;
+
+            // 打包：a_pack[(ib * kc + t) * MR + r] 为第 kk+t 行、第 ib*MR+r 列，b_pack 同理；不足的列补 0
+            for (size_t t = 0; t != kc; ++t){
+                const double *a_row = a_data + (kk + t) * a_cols, *b_row = b_data + (kk + t) * b_cols;
+                for (size_t ib = 0; ib != a_blocks; ++ib){
+                    size_t col = ib * MATRIX_MR, remain = a_cols - col;
+                    __mmask8 mask = remain >= MATRIX_MR ? (1 << MATRIX_MR) - 1 : (1 << remain) - 1;
+                    __m512d x = _mm512_maskz_loadu_pd(mask, a_row + col);
+                    x = _mm512_maskz_mov_pd(mask, a_func(x, kk + t, col, mask));
+                    _mm512_mask_storeu_pd(a_pack + (ib * kc + t) * MATRIX_MR, (1 << MATRIX_MR) - 1, x);
+                }
+                for (size_t jb = 0; jb != b_blocks; ++jb){
+                    #pragma GCC unroll 4
+                    for (size_t k = 0; k != 4; ++k){
+                        size_t col = jb * MATRIX_NR + 8 * k;
+                        __mmask8 mask = b_mask[jb * 4 + k];
+                        __m512d x = _mm512_maskz_loadu_pd(mask, b_row + col);
+                        x = _mm512_maskz_mov_pd(mask, b_func(x, kk + t, col, mask));
+                        _mm512_storeu_pd(b_pack + (jb * kc + t) * MATRIX_NR + 8 * k, x);
+                    }
+                }
+            }
+
+            for (size_t ic = 0; ic < a_blocks; ic += MATRIX_MC / MATRIX_MR){
+                size_t ic_end = ic + MATRIX_MC / MATRIX_MR < a_blocks ? ic + MATRIX_MC / MATRIX_MR : a_blocks;
+                for (size_t jb = 0; jb != b_blocks; ++jb){
+                    for (size_t ib = ic; ib != ic_end; ++ib){
+                        // 整块都在对角线以下
+                        if (symmetric && (jb + 1) * MATRIX_NR <= ib * MATRIX_MR){
+                            continue;
+                        }
+                        size_t rows = a_cols - ib * MATRIX_MR < MATRIX_MR ? a_cols - ib * MATRIX_MR : MATRIX_MR;
+                        avx_gemm_kernel(a_pack + ib * kc * MATRIX_MR, b_pack + jb * kc * MATRIX_NR, kc,
+                                        out + ib * MATRIX_MR * b_cols + jb * MATRIX_NR, b_cols, rows, b_mask + jb * 4);
+                    }
+                }
+            }
+        }
+
+        if (symmetric){
+            for (size_t i = 1; i < a_cols; ++i){
+                for (size_t j = 0; j != i; ++j){
+                    out[i * a_cols + j] = out[j * a_cols + i];
+                }
+            }
+        }
+
+        delete[] a_pack;
+        delete[] b_pack;
+        delete[] b_mask;
+    }
+
+
+    /**
+     * @brief 协方差矩阵与相关系数矩阵的公共部分。
+     *        没有 NaN 时（或 NAN_POLICY 不忽略 NaN 时）：先按列中心化，out = X^T X，即未除以自由度的协方差，
+     *        NaN 经由 FMA 传播到它所在的行与列；
+     *        NAN_POLICY 为 SKIP_NAN 且有 NaN 时：与 covar 相同按对忽略 NaN，记有效标记 M、NaN 置 0 的中心化数据 X0，
+     *        用 4 次 X^T Y 求出每一对的 n = M^T M、sxy = X0^T X0、sx = X0^T M、sxx = (X0^2)^T M
+     * @return 是否走了按对忽略 NaN 的路径，此时 n、sx、sxx 为 nCols × nCols 的临时矩阵（由调用者释放）
+     */
+    template <typename NAN_POLICY>
+    inline bool
+    matrix_moments(const double *data, size_t nRows, size_t nCols, double *out,
+                    double *&n, double *&sx, double *&sxx)
+    {
+        double *mean = new double[nCols + 8]();
+        batch_mean<NAN_POLICY>(data, nRows, nCols, mean);
+
+        auto center = [=](__m512d x, size_t, size_t col, __mmask8 mask){
+            return _mm512_sub_pd(x, _mm512_maskz_loadu_pd(mask, mean + col));
+        };
+
+        if (!NAN_POLICY::skip_nan || !has_nan(data, nRows * nCols)){
+            avx_gemm_tn(data, nCols, data, nCols, nRows, center, center, true, out);
+            delete[] mean;
+            return false;
+        }
+
+        const __m512d avx_one = _mm512_set1_pd(1);
+        auto valid_center = [=](__m512d x, size_t, size_t col, __mmask8 mask){
+            return _mm512_maskz_sub_pd(avx_valid_mask(x) & mask, x, _mm512_maskz_loadu_pd(mask, mean + col));
+        };
+        auto valid_center_pow2 = [=](__m512d x, size_t, size_t col, __mmask8 mask){
+            x = _mm512_maskz_sub_pd(avx_valid_mask(x) & mask, x, _mm512_maskz_loadu_pd(mask, mean + col));
+            return _mm512_mul_pd(x, x);
+        };
+        auto valid_one = [=](__m512d x, size_t, size_t, __mmask8 mask){
+            return _mm512_maskz_mov_pd(avx_valid_mask(x) & mask, avx_one);
+        };
+
+        n = new double[nCols * nCols];
+        sx = new double[nCols * nCols];
+        sxx = new double[nCols * nCols];
+        avx_gemm_tn(data, nCols, data, nCols, nRows, valid_one, valid_one, true, n);
+        avx_gemm_tn(data, nCols, data, nCols, nRows, valid_center, valid_center, true, out);
+        avx_gemm_tn(data, nCols, data, nCols, nRows, valid_center, valid_one, false, sx);
+        avx_gemm_tn(data, nCols, data, nCols, nRows, valid_center_pow2, valid_one, false, sxx);
+        delete[] mean;
+        return true;
+    }
+
+
+    /**
+     * @brief 协方差矩阵，out[i * nCols + j] 与 covar(第 i 列, 第 j 列, nRows, bias) 相同：
+     *        NAN_POLICY 为 SKIP_NAN 时按对忽略 NaN（没有 NaN 时只需一次 SYRK，有 NaN 时需要 4 次 X^T Y 与 3 个临时矩阵）
+     * @param data nRows × nCols 的矩阵，按行连续存放
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param bias 是否为有偏估计
+     * @param out 输出数组，nCols × nCols
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline void
+    covar_matrix(const double *data, size_t nRows, size_t nCols, bool bias, double *out)
+    {
+        double *n = NULL, *sx = NULL, *sxx = NULL;
+
+        // 与 covar 相同，有效长度不足时为 NaN（否则 nRows - 1 会回绕成 SIZE_MAX）
+        if (nRows < (bias ? 1u : 2u)){
+            for (size_t i = 0; i != nCols * nCols; ++i){
+                out[i] = NAN;
+            }
+            return;
+        }
+        if (!matrix_moments<NAN_POLICY>(data, nRows, nCols, out, n, sx, sxx)){
+            const __m512d avx_scale = _mm512_set1_pd(1.0 / (bias ? nRows : nRows - 1));
+            size_t total = nCols * nCols;
+            __mmask8 mask;
+            for (size_t i = 0; i < total; i += 8){
+                mask = total - i >= 8 ? 0xff : (1 << (total - i)) - 1;
+                _mm512_mask_storeu_pd(out + i, mask, _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, out + i), avx_scale));
+            }
+            return;
+        }
+
+        for (size_t i = 0; i != nCols; ++i){
+            for (size_t j = 0; j != nCols; ++j){
+                size_t ij = i * nCols + j, ji = j * nCols + i;
+                out[ij] = (out[ij] - sx[ij] * sx[ji] / n[ij]) / (bias ? n[ij] : n[ij] - 1);
+            }
+        }
+        delete[] n;
+        delete[] sx;
+        delete[] sxx;
+    }
+
+
+    /**
+     * @brief 相关系数矩阵，out[i * nCols + j] 与 corr(第 i 列, 第 j 列, nRows) 相同，结果限制在 [-1, 1] 内；
+     *        NaN 的处理见 covar_matrix
+     * @param data nRows × nCols 的矩阵，按行连续存放
+     * @param nRows 时刻数
+     * @param nCols 品种数
+     * @param out 输出数组，nCols × nCols
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline void
+    corr_matrix(const double *data, size_t nRows, size_t nCols, double *out)
+    {
+        double *n = NULL, *sx = NULL, *sxx = NULL;
+        double res;
+
+        // 与 corr 相同，少于 2 个时刻时为 NaN
+        if (nRows < 2){
+            for (size_t i = 0; i != nCols * nCols; ++i){
+                out[i] = NAN;
+            }
+            return;
+        }
+        if (!matrix_moments<NAN_POLICY>(data, nRows, nCols, out, n, sx, sxx)){
+            double *inv_std = new double[nCols];
+            for (size_t i = 0; i != nCols; ++i){
+                inv_std[i] = 1 / sqrt(out[i * nCols + i]);
+            }
+            for (size_t i = 0; i != nCols; ++i){
+                for (size_t j = 0; j != nCols; ++j){
+                    res = out[i * nCols + j] * inv_std[i] * inv_std[j];
+                    out[i * nCols + j] = res > 1 ? 1 : (res < -1 ? -1 : res);
+                }
+            }
+            delete[] inv_std;
+            return;
+        }
+
+        for (size_t i = 0; i != nCols; ++i){
+            for (size_t j = 0; j != nCols; ++j){
+                size_t ij = i * nCols + j, ji = j * nCols + i;
+                res = (n[ij] * out[ij] - sx[ij] * sx[ji]) /
+                    sqrt((n[ij] * sxx[ij] - sx[ij] * sx[ij]) * (n[ij] * sxx[ji] - sx[ji] * sx[ji]));
+                out[ij] = res > 1 ? 1 : (res < -1 ? -1 : res);
+            }
+        }
+        delete[] n;
+        delete[] sx;
+        delete[] sxx;
+    }
+
+
+    /**
+     * @brief 短数组的点乘，不检查 NaN
+     */
+    __attribute__((__always_inline__)) inline double
+    avx_small_dot(const double *x, const double *y, size_t nLength)
+    {
+        __m512d avx_sum = _mm512_setzero_pd();
+        __mmask8 mask;
+        for (size_t i = 0; i < nLength; i += 8){
+            mask = nLength - i >= 8 ? 0xff : (1 << (nLength - i)) - 1;
+            avx_sum = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), avx_sum);
+        }
+        return _mm512_reduce_add_pd(avx_sum);
+    }
+
+
+    /**
+     * @brief y += a * x，不检查 NaN
+     */
+    __attribute__((__always_inline__)) inline void
+    avx_axpy(double a, const double *x, double *y, size_t nLength)
+    {
+        const __m512d avx_a = _mm512_set1_pd(a);
+        __mmask8 mask;
+        for (size_t i = 0; i < nLength; i += 8){
+            mask = nLength - i >= 8 ? 0xff : (1 << (nLength - i)) - 1;
+            _mm512_mask_storeu_pd(y + i, mask, 
+                _mm512_fmadd_pd(avx_a, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i)));
+        }
+    }
+
+
+    /**
+     * @brief Cholesky 分解 A = L L^T：A 为 k × k 的对称正定矩阵，第 i 行从 a + i * lda 开始，只读下三角；
+     *        L 原地写入下三角。按行计算，L[i][j] 只用到 L 的第 i、j 行的前 j 个数，都是连续的点乘
+     * @return A 是否正定（有 NaN 时为 false）
+     */
+    inline bool
+    cholesky(double *a, size_t k, size_t lda)
+    {
+        for (size_t j = 0; j != k; ++j){
+            double *row_j = a + j * lda;
+            double d = row_j[j] - avx_small_dot(row_j, row_j, j);
+            if (!(d > 0)){
+                return false;
+            }
+            row_j[j] = d = sqrt(d);
+            for (size_t i = j + 1; i != k; ++i){
+                double *row_i = a + i * lda;
+                row_i[j] = (row_i[j] - avx_small_dot(row_i, row_j, j)) / d;
+            }
+        }
+        return true;
+    }
+
+
+    /**
+     * @brief 用 cholesky 的结果解 L L^T x = b，x 原地写入 b
+     */
+    inline void
+    cholesky_solve(const double *l, size_t k, size_t lda, double *b)
+    {
+        // L z = b
+        for (size_t i = 0; i != k; ++i){
+            b[i] = (b[i] - avx_small_dot(l + i * lda, b, i)) / l[i * lda + i];
+        }
+        // L^T x = z：x[i] 求出后从前面的 b 中减去 L 第 i 行的贡献
+        for (size_t i = k; i-- != 0; ){
+            b[i] /= l[i * lda + i];
+            avx_axpy(-b[i], l + i * lda, b, i);
+        }
+    }
+
+
+    /**
+     * @brief 用 cholesky 的结果求 A^{-1} 的对角线：A^{-1} = L^{-T} L^{-1}，(A^{-1})_ii 为 L^{-1} 第 i 列的平方和
+     * @param diag 输出数组，长度为 k
+     */
+    inline void
+    cholesky_inv_diag(const double *l, size_t k, size_t lda, double *diag)
+    {
+        // z 为 L^{-1}，按行求：z[r] = (e_r - sum(L[r][p] * z[p], p < r)) / L[r][r]
+        double *z = new double[k * k]();
+        memset(diag, 0, sizeof(double) * k);
+        for (size_t r = 0; r != k; ++r){
+            double *z_r = z + r * k;
+            z_r[r] = 1;
+            for (size_t p = 0; p != r; ++p){
+                avx_axpy(-l[r * lda + p], z + p * k, z_r, p + 1);
+            }
+            for (size_t c = 0; c <= r; ++c){
+                z_r[c] /= l[r * lda + r];
+                diag[c] += z_r[c] * z_r[c];
+            }
+        }
+        delete[] z;
+    }
+
+
+    /**
+     * @brief 一行 k 个数是否都有效（NaN 的处理由 NAN_POLICY 决定），同时复制到 dst（dst 为 NULL 时不复制）
+     */
+    template <typename NAN_POLICY>
+    __attribute__((__always_inline__)) inline bool
+    row_valid(const double *row, size_t k, double *dst)
+    {
+        __mmask8 mask, invalid = 0;
+        for (size_t i = 0; i < k; i += 8){
+            mask = k - i >= 8 ? 0xff : (1 << (k - i)) - 1;
+            __m512d x = _mm512_maskz_loadu_pd(mask, row + i);
+            invalid |= mask & ~NAN_POLICY::valid_mask(x, mask);
+            if (dst){
+                _mm512_mask_storeu_pd(dst + i, mask, x);
+            }
+        }
+        return invalid == 0;
+    }
+
+
+    /**
+     * @brief 多元线性回归 y = X coef + e（不自动加截距，需要截距时在 X 中加一列 1），
+     *        与 beta 相同，X 的某行或 y 的该位置有 NaN 时忽略这一行。
+     *        一次遍历累加增广矩阵 [X y]^T [X y]（即 X^T X、X^T y），再用 Cholesky 分解求解
+     * @param X nLength × k 的矩阵，按行连续存放，X[t * k + f] 为第 t 个样本的第 f 个因子
+     * @param y 长度为 nLength 的数组
+     * @param k 因子数
+     * @param nLength 样本数
+     * @param coef 输出数组，长度为 k；X^T X 奇异时为 NaN
+     * @param resid 输出数组，长度为 nLength，忽略的行为 NaN；为 NULL 时不输出
+     * @param std_err 输出数组，长度为 k，系数的标准误 sqrt(ssr / (n - k) * (X^T X)^{-1}_ff)；为 NULL 时不输出
+     * @return R^2 = 1 - ssr / sum((y - mean(y))^2)
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    ols(const double *X, const double *y, size_t k, size_t nLength, 
+        double *coef, double *resid = NULL, double *std_err = NULL)
+    {
+        // gram 与 z 的每行补齐到 8 的倍数，补齐的部分为 0
+        size_t m = k + 1, ld = (m + 7) & ~0x7, count = 0, filled = 0;
+        double *gram = new double[m * ld]();
+        double *z = new double[8 * ld]();
+        double y_sum = 0, ssr = 0, tss = 0, r2 = NAN;
+
+        // 每攒够 8 个有效行，把它们对 gram 的贡献在寄存器中累加后一次写回
+        auto flush = [&](){
+            for (size_t i = 0; i != m; ++i){
+                for (size_t v = 0; v != ld; v += 8){
+                    __m512d acc = _mm512_loadu_pd(gram + i * ld + v);
+                    for (size_t r = 0; r != filled; ++r){
+                        acc = _mm512_fmadd_pd(_mm512_set1_pd(z[r * ld + i]), _mm512_loadu_pd(z + r * ld + v), acc);
+                    }
+                    _mm512_storeu_pd(gram + i * ld + v, acc);
+                }
+            }
+            filled = 0;
+        };
+        for (size_t t = 0; t != nLength; ++t){
+            if (!row_valid<NAN_POLICY>(X + t * k, k, z + filled * ld) || !NAN_POLICY::valid(y[t])){
+                continue;
+            }
+            z[filled * ld + k] = y[t];
+            ++count;
+            y_sum += y[t];
+            if (++filled == 8){
+                flush();
+            }
+        }
+        flush();
+
+        if (!cholesky(gram, k, ld)){
+            for (size_t f = 0; f != k; ++f){
+                coef[f] = NAN;
+                if (std_err){
+                    std_err[f] = NAN;
+                }
+            }
+            if (resid){
+                for (size_t t = 0; t != nLength; ++t){
+                    resid[t] = NAN;
+                }
+            }
+            delete[] gram;
+            delete[] z;
+            return NAN;
+        }
+        memcpy(coef, gram + k * ld, sizeof(double) * k);
+        cholesky_solve(gram, k, ld, coef);
+
+        double y_mean = y_sum / count;
+        for (size_t t = 0; t != nLength; ++t){
+            const double *row = X + t * k;
+            bool valid = row_valid<NAN_POLICY>(row, k, NULL) && NAN_POLICY::valid(y[t]);
+            double e = valid ? y[t] - avx_small_dot(row, coef, k) : NAN;
+            if (resid){
+                resid[t] = e;
+            }
+            if (valid){
+                ssr += e * e;
+                tss += (y[t] - y_mean) * (y[t] - y_mean);
+            }
+        }
+        r2 = 1 - ssr / tss;
+
+        if (std_err){
+            cholesky_inv_diag(gram, k, ld, std_err);
+            double sigma2 = count > k ? ssr / (count - k) : NAN;
+            for (size_t f = 0; f != k; ++f){
+                std_err[f] = sqrt(sigma2 * std_err[f]);
+            }
+        }
+
+        delete[] gram;
+        delete[] z;
+        return r2;
+    }
+
+
+    /**
+     * @brief 对同一个 X 批量回归 nSeries 个 y：X^T X 只分解一次，X^T Y 用 avx_gemm_tn 一次算出。
+     *        X 的某行有 NaN 时所有序列都忽略这一行；某个序列的 y 在其余行中有 NaN 时，该序列改用 ols 单独计算
+     * @param X nLength × k 的矩阵，按行连续存放
+     * @param Y nLength × nSeries 的矩阵，按行连续存放，Y[t * nSeries + s] 为第 s 个序列的第 t 个样本
+     * @param k 因子数
+     * @param nLength 样本数
+     * @param nSeries 序列数
+     * @param coef 输出数组，k × nSeries，coef[f * nSeries + s] 为第 s 个序列的第 f 个系数
+     * @param r2 输出数组，长度为 nSeries
+     * @param resid 输出数组，nLength × nSeries，与 Y 的存放方式相同；为 NULL 时不输出
+     * @param std_err 输出数组，k × nSeries，与 coef 的存放方式相同；为 NULL 时不输出
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline void
+    ols_batch(const double *X, const double *Y, size_t k, size_t nLength, size_t nSeries, 
+            double *coef, double *r2, double *resid = NULL, double *std_err = NULL)
+    {
+        const __m512d avx_one = _mm512_set1_pd(1);
+        unsigned char *valid_row = new unsigned char[nLength];
+        double *xtx = new double[k * k];
+        double *y_mean = new double[nSeries + 8]();
+        double *nan_count = new double[nSeries + 8]();
+        double *ssr = new double[nSeries + 8]();
+        double *tss = new double[nSeries + 8]();
+        double *e = new double[nSeries + 8];
+        double *b = new double[k + 8];
+        size_t count = 0;
+        __mmask8 mask, valid;
+
+        // 有效的行，与每个序列在有效行中的 NaN 个数、平均值
+        for (size_t t = 0; t != nLength; ++t){
+            valid_row[t] = row_valid<NAN_POLICY>(X + t * k, k, NULL);
+            if (!valid_row[t]){
+                continue;
+            }
+            ++count;
+            const double *y_row = Y + t * nSeries;
+            for (size_t s = 0; s < nSeries; s += 8){
+                mask = nSeries - s >= 8 ? 0xff : (1 << (nSeries - s)) - 1;
+                __m512d avx_y = _mm512_maskz_loadu_pd(mask, y_row + s);
+                valid = NAN_POLICY::valid_mask(avx_y, mask);
+                _mm512_mask_storeu_pd(y_mean + s, valid, _mm512_add_pd(_mm512_loadu_pd(y_mean + s), avx_y));
+                _mm512_mask_storeu_pd(nan_count + s, mask & ~valid, _mm512_add_pd(_mm512_loadu_pd(nan_count + s), avx_one));
+            }
+        }
+        for (size_t s = 0; s != nSeries; ++s){
+            y_mean[s] /= count;
+        }
+
+        // X^T X 与 X^T Y，忽略的行与 NaN 都按 0 打包
+        auto x_func = [=](__m512d x, size_t t, size_t, __mmask8 mask){
+            return _mm512_maskz_mov_pd(valid_row[t] ? mask : 0, x);
+        };
+        auto y_func = [=](__m512d x, size_t t, size_t, __mmask8 mask){
+            return _mm512_maskz_mov_pd(valid_row[t] ? NAN_POLICY::valid_mask(x, mask) : 0, x);
+        };
+        avx_gemm_tn(X, k, X, k, nLength, x_func, x_func, true, xtx);
+        avx_gemm_tn(X, k, Y, nSeries, nLength, x_func, y_func, false, coef);
+
+        bool ok = cholesky(xtx, k, k);
+        for (size_t s = 0; s != nSeries; ++s){
+            for (size_t f = 0; f != k; ++f){
+                b[f] = coef[f * nSeries + s];
+            }
+            if (ok){
+                cholesky_solve(xtx, k, k, b);
+            }
+            for (size_t f = 0; f != k; ++f){
+                coef[f * nSeries + s] = ok ? b[f] : NAN;
+            }
+        }
+
+        // 残差：e = y - sum(X[t][f] * coef[f])，每行对所有序列一起计算
+        for (size_t t = 0; t != nLength; ++t){
+            const double *y_row = Y + t * nSeries;
+            double *e_row = resid ? resid + t * nSeries : e;
+            if (!valid_row[t]){
+                if (resid){
+                    for (size_t s = 0; s != nSeries; ++s){
+                        e_row[s] = NAN;
+                    }
+                }
+                continue;
+            }
+            memcpy(e_row, y_row, sizeof(double) * nSeries);
+            for (size_t f = 0; f != k; ++f){
+                avx_axpy(-X[t * k + f], coef + f * nSeries, e_row, nSeries);
+            }
+            for (size_t s = 0; s < nSeries; s += 8){
+                mask = nSeries - s >= 8 ? 0xff : (1 << (nSeries - s)) - 1;
+                __m512d avx_e = _mm512_maskz_loadu_pd(mask, e_row + s);
+                __m512d avx_d = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, y_row + s), _mm512_loadu_pd(y_mean + s));
+                valid = NAN_POLICY::valid_mask(avx_e, mask);
+                _mm512_mask_storeu_pd(ssr + s, valid, _mm512_fmadd_pd(avx_e, avx_e, _mm512_loadu_pd(ssr + s)));
+                _mm512_mask_storeu_pd(tss + s, valid, _mm512_fmadd_pd(avx_d, avx_d, _mm512_loadu_pd(tss + s)));
+            }
+        }
+
+        if (std_err){
+            if (ok){
+                cholesky_inv_diag(xtx, k, k, b);
+            }
+            for (size_t s = 0; s != nSeries; ++s){
+                double sigma2 = ok && count > k ? ssr[s] / (count - k) : NAN;
+                for (size_t f = 0; f != k; ++f){
+                    std_err[f * nSeries + s] = sqrt(sigma2 * b[f]);
+                }
+            }
+        }
+        for (size_t s = 0; s != nSeries; ++s){
+            r2[s] = ok ? 1 - ssr[s] / tss[s] : NAN;
+        }
+
+        // y 中有 NaN 的序列各自的有效行不同，不能共用分解
+        double *y_col = NULL, *coef_col = NULL, *resid_col = NULL, *std_err_col = NULL;
+        for (size_t s = 0; s != nSeries; ++s){
+            if (nan_count[s] == 0){
+                continue;
+            }
+            if (y_col == NULL){
+                y_col = new double[nLength];
+                resid_col = new double[nLength];
+                coef_col = new double[k];
+                std_err_col = new double[k];
+            }
+            for (size_t t = 0; t != nLength; ++t){
+                y_col[t] = Y[t * nSeries + s];
+            }
+            r2[s] = ols<NAN_POLICY>(X, y_col, k, nLength, coef_col, resid_col, std_err_col);
+            for (size_t f = 0; f != k; ++f){
+                coef[f * nSeries + s] = coef_col[f];
+                if (std_err){
+                    std_err[f * nSeries + s] = std_err_col[f];
+                }
+            }
+            if (resid){
+                for (size_t t = 0; t != nLength; ++t){
+                    resid[t * nSeries + s] = resid_col[t];
+                }
+            }
+        }
+
+        delete[] valid_row;
+        delete[] xtx;
+        delete[] y_mean;
+        delete[] nan_count;
+        delete[] ssr;
+        delete[] tss;
+        delete[] e;
+        delete[] b;
+        delete[] y_col;
+        delete[] coef_col;
+        delete[] resid_col;
+        delete[] std_err_col;
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef FAST_MATH_NUMA_H
+#define FAST_MATH_NUMA_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <vector>
+
+
+// FAST_MATH 的 CPU / NUMA 拓扑：从 /sys/devices/system/node 读取每个节点的 CPU，不依赖 libnuma。
+// 没有该目录（或只有一个节点）时视为单节点，调用者的行为与不区分节点时相同
+namespace FAST_MATH
+{
+    /**
+     * @brief 当前进程可以使用的 CPU
+     */
+    inline std::vector<int>
+    available_cpus()
+    {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0){
+            for (int cpu = 0; cpu != CPU_SETSIZE; ++cpu){
+                if (CPU_ISSET(cpu, &set)){
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        return cpus;
+    }
+
+
+    /**
+     * @brief 读取 /sys 中形如 "0-23,48-71" 的编号列表（cpulist 格式），文件不存在时返回空
+     */
+    inline std::vector<int>
+    read_id_list(const char *path)
+    {
+        std::vector<int> ids;
+        FILE *file = fopen(path, "r");
+        if (file == NULL){
+            return ids;
+        }
+        int first, last;
+        while (fscanf(file, "%d", &first) == 1){
+            last = first;
+            int c = fgetc(file);
+            if (c == '-'){
+                if (fscanf(file, "%d", &last) != 1){
+                    break;
+                }
+                c = fgetc(file);
+            }
+            for (int id = first; id <= last; ++id){
+                ids.push_back(id);
+            }
+            if (c != ','){
+                break;
+            }
+        }
+        fclose(file);
+        return ids;
+    }
+
+
+    /**
+     * @brief 编号为 node 的 NUMA 节点上的 CPU，读取 /sys/devices/system/node/node<node>/cpulist；
+     *        节点不存在或没有 CPU 时返回空
+     */
+    inline std::vector<int>
+    numa_node_cpus(int node)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        return read_id_list(path);
+    }
+
+
+    /**
+     * @brief 有 CPU 的 NUMA 节点的编号，从小到大：读取 /sys/devices/system/node/online，跳过没有 CPU 的节点。
+     *        只有内存的节点（如 CXL 内存）可能排在有 CPU 的节点之前，节点编号也不一定连续，
+     *        因此其余函数中的“第 i 个节点”都指这里的第 i 个。没有该目录时为 {0}
+     */
+    inline std::vector<int>
+    numa_nodes()
+    {
+        std::vector<int> nodes;
+        for (int node : read_id_list("/sys/devices/system/node/online")){
+            if (!numa_node_cpus(node).empty()){
+                nodes.push_back(node);
+            }
+        }
+        if (nodes.empty()){
+            nodes.push_back(0);
+        }
+        return nodes;
+    }
+
+
+    /**
+     * @brief 有 CPU 的 NUMA 节点数，见 numa_nodes；没有 /sys/devices/system/node 时为 1
+     */
+    inline int
+    numa_node_count()
+    {
+        return numa_nodes().size();
+    }
+
+
+    /**
+     * @brief 每个 CPU 所在的 NUMA 节点，res[cpu] 为节点在 numa_nodes() 中的序号，不属于任何节点的 CPU 为 0
+     */
+    inline std::vector<int>
+    numa_cpu_nodes()
+    {
+        std::vector<int> res(CPU_SETSIZE, 0);
+        std::vector<int> nodes = numa_nodes();
+        for (size_t i = 0; i != nodes.size(); ++i){
+            for (int cpu : numa_node_cpus(nodes[i])){
+                if (cpu < CPU_SETSIZE){
+                    res[cpu] = i;
+                }
+            }
+        }
+        return res;
+    }
+
+
+    /**
+     * @brief 把线程 thread 绑定到 cpus 中进程可以使用的 CPU 上，cpus 与进程可用的 CPU 没有交集时不做修改
+     */
+    inline bool
+    pin_thread(pthread_t thread, const std::vector<int> &cpus)
+    {
+        cpu_set_t allowed, set;
+        CPU_ZERO(&allowed);
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+            return false;
+        }
+        bool any = false;
+        for (int cpu : cpus){
+            if (cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)){
+                CPU_SET(cpu, &set);
+                any = true;
+            }
+        }
+        return any && pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+    }
+}
+
+#endif
@@ -0,0 +1,540 @@
+#ifndef FAST_MATH_ONLINE_H
+#define FAST_MATH_ONLINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+#include <immintrin.h>
+#include <math.h>
+#include "fast_math.h"
+
+
+// FAST_MATH 的在线（逐笔）统计：数据一个一个到来时，每次 push 只需 O(1) 更新状态，
+// 任意时刻都可以取出与对整段数据调用 var / covar / beta 等相同的结果（忽略 NaN，bias 含义相同）。
+// merge 把另一个状态并入当前状态，结果与把两段数据放在一起计算相同，可用于合并各线程的部分结果。
+// 带 _X8 后缀的版本同时维护 8 个品种（每个 lane 一个），一次 push 8 个品种在同一时刻的值
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512cd,avx512bw,avx512vl,fma,popcnt")
+
+namespace FAST_MATH
+{
+    /**
+     * @brief 在线求个数、均值、方差、标准差、偏度与峰度
+     */
+    struct ONLINE_MOMENTS
+    {
+        moments state;
+
+        ONLINE_MOMENTS()
+        {
+            state.count = 0;
+            state.mean = state.m2 = state.m3 = state.m4 = 0;
+        }
+
+        /**
+         * @brief 加入一个数，NaN 被忽略；即 moments_merge 中 b 只有一个数的情形
+         */
+        __attribute__((__always_inline__)) inline void
+        push(double x)
+        {
+            if (isnan(x)){
+                return;
+            }
+            double n1 = state.count, n = n1 + 1;
+            double delta = x - state.mean, delta_n = delta / n, delta_n2 = delta_n * delta_n;
+            double term = delta * delta_n * n1;
+
+            state.count += 1;
+            state.mean += delta_n;
+            state.m4 += term * delta_n2 * (n * n - 3 * n + 3) + 6 * delta_n2 * state.m2 - 4 * delta_n * state.m3;
+            state.m3 += term * delta_n * (n - 2) - 3 * delta_n * state.m2;
+            state.m2 += term;
+        }
+
+        /**
+         * @brief 加入一段数，NaN 被忽略
+         */
+        __attribute__((__always_inline__)) inline void
+        push(const double *data, size_t nLength)
+        {
+            state = moments_merge(state, calc_moments(data, nLength));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        merge(const ONLINE_MOMENTS &other)
+        {
+            state = moments_merge(state, other.state);
+        }
+
+        __attribute__((__always_inline__)) inline size_t
+        count() const
+        {
+            return state.count;
+        }
+
+        __attribute__((__always_inline__)) inline double
+        mean() const
+        {
+            return state.count ? state.mean : NAN;
+        }
+
+        __attribute__((__always_inline__)) inline double
+        var(bool bias) const
+        {
+            return moments_var(state, bias);
+        }
+
+        __attribute__((__always_inline__)) inline double
+        std(bool bias) const
+        {
+            return sqrt(moments_var(state, bias));
+        }
+
+        __attribute__((__always_inline__)) inline double
+        skew() const
+        {
+            return moments_skew(state);
+        }
+
+        __attribute__((__always_inline__)) inline double
+        kurt() const
+        {
+            return moments_kurt(state);
+        }
+    };
+
+
+    /**
+     * @brief 在线求两组数的协方差、相关系数与 beta（y 对 x 回归），
+     *        若某组数某处为 NaN，则两组数的该位置都被忽略
+     */
+    struct ONLINE_COVAR
+    {
+        size_t n;
+        double x_mean, y_mean;
+        double sxx, syy, sxy;   // 离差平方和与离差积和
+
+        ONLINE_COVAR() : n(0), x_mean(0), y_mean(0), sxx(0), syy(0), sxy(0) {}
+
+        __attribute__((__always_inline__)) inline void
+        push(double x, double y)
+        {
+            if (isnan(x * y)){
+                return;
+            }
+            n += 1;
+            double dx = x - x_mean, dy = y - y_mean;
+            x_mean += dx / n;
+            y_mean += dy / n;
+            sxx += dx * (x - x_mean);
+            syy += dy * (y - y_mean);
+            sxy += dx * (y - y_mean);
+        }
+
+        __attribute__((__always_inline__)) inline void
+        push(const double *x_data, const double *y_data, size_t nLength);
+
+        __attribute__((__always_inline__)) inline void
+        merge(const ONLINE_COVAR &other)
+        {
+            if (other.n == 0){
+                return;
+            }
+            if (n == 0){
+                *this = other;
+                return;
+            }
+            double na = n, nb = other.n, total = na + nb;
+            double dx = other.x_mean - x_mean, dy = other.y_mean - y_mean, w = na * nb / total;
+            sxx += other.sxx + dx * dx * w;
+            syy += other.syy + dy * dy * w;
+            sxy += other.sxy + dx * dy * w;
+            x_mean += dx * nb / total;
+            y_mean += dy * nb / total;
+            n += other.n;
+        }
+
+        __attribute__((__always_inline__)) inline size_t
+        count() const
+        {
+            return n;
+        }
+
+        __attribute__((__always_inline__)) inline double
+        covar(bool bias) const
+        {
+            if (n == 0){
+                return NAN;
+            }
+            return sxy / (bias ? n : n - 1.0);
+        }
+
+        __attribute__((__always_inline__)) inline double
+        corr() const
+        {
+            return sxy / sqrt(sxx * syy);
+        }
+
+        __attribute__((__always_inline__)) inline double
+        beta() const
+        {
+            return sxy / sxx;
+        }
+    };
+
+
+    /**
+     * @brief 一段数的 ONLINE_COVAR 状态，只读一遍内存：以第一对有效的数 (x0, y0) 为原点累加
+     *        dx = x - x0、dy = y - y0 的和、平方和与积和，再换算成离差平方和，平移后原始累加和不会很大，不易损失精度。
+     *        NaN 的处理由 NAN_POLICY 决定（默认忽略，若某组数某处为 NaN，则两组数的该位置都被忽略）
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    __attribute__((__always_inline__)) inline ONLINE_COVAR
+    calc_comoments(const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength)
+    {
+        ONLINE_COVAR res;
+        size_t first = 0;
+        while (first != nLength && !NAN_POLICY::valid(x_data[first] * y_data[first])){
+            ++first;
+        }
+        if (first == nLength){
+            return res;
+        }
+
+        const __m512d avx_x0 = _mm512_set1_pd(x_data[first]), avx_y0 = _mm512_set1_pd(y_data[first]);
+        __m512d avx_x, avx_y, avx_x_sum, avx_y_sum, avx_xx, avx_yy, avx_xy;
+        __mmask8 mask, valid;
+        size_t count = 0;
+
+        avx_x_sum = avx_y_sum = avx_xx = avx_yy = avx_xy = _mm512_setzero_pd();
+        for (size_t i = first; i < nLength; i += 8){
+            mask = nLength - i >= 8 ? 0xff : (1 << (nLength - i)) - 1;
+            avx_x = _mm512_maskz_loadu_pd(mask, x_data+i);
+            avx_y = _mm512_maskz_loadu_pd(mask, y_data+i);
+            valid = NAN_POLICY::valid_mask(_mm512_mul_pd(avx_x, avx_y), mask);
+            count += _mm_popcnt_u32(valid);
+            avx_x = _mm512_maskz_sub_pd(valid, avx_x, avx_x0);
+            avx_y = _mm512_maskz_sub_pd(valid, avx_y, avx_y0);
+            avx_x_sum = _mm512_add_pd(avx_x_sum, avx_x);
+            avx_y_sum = _mm512_add_pd(avx_y_sum, avx_y);
+            avx_xx = _mm512_fmadd_pd(avx_x, avx_x, avx_xx);
+            avx_yy = _mm512_fmadd_pd(avx_y, avx_y, avx_yy);
+            avx_xy = _mm512_fmadd_pd(avx_x, avx_y, avx_xy);
+        }
+
+        double dx = _mm512_reduce_add_pd(avx_x_sum) / count, dy = _mm512_reduce_add_pd(avx_y_sum) / count;
+        res.n = count;
+        res.x_mean = x_data[first] + dx;
+        res.y_mean = y_data[first] + dy;
+        res.sxx = _mm512_reduce_add_pd(avx_xx) - dx * dx * count;
+        res.syy = _mm512_reduce_add_pd(avx_yy) - dy * dy * count;
+        res.sxy = _mm512_reduce_add_pd(avx_xy) - dx * dy * count;
+        return res;
+    }
+
+
+    /**
+     * @brief 加入一段数，NaN 被忽略
+     */
+    __attribute__((__always_inline__)) inline void
+    ONLINE_COVAR::push(const double *x_data, const double *y_data, size_t nLength)
+    {
+        merge(calc_comoments(x_data, y_data, nLength));
+    }
+
+
+    // beta 与协方差共用同一个状态
+    typedef ONLINE_COVAR ONLINE_BETA;
+
+
+    /**
+     * @brief 在线求指数移动平均，与 vec_ema(adjust = false) 相同：
+     *        从第一个非 NaN 的数开始递推，NaN 不更新
+     * @details
+     * 除当前值 value 外，还记录从 0 开始递推的值 zero_value 与衰减系数 decay = (1-alpha)^count，
+     * 即这段数把之前的值 y 变为 decay * y + zero_value，因此前后两段可以合并
+     */
+    struct ONLINE_EMA
+    {
+        double beta, beta_1sub;
+        size_t n;
+        double value, zero_value, decay;
+
+        /**
+         * @param span 平均的跨度，alpha = 2 / (span + 1)
+         */
+        explicit ONLINE_EMA(double span)
+            : beta(2 / (span + 1)), beta_1sub(1 - beta), n(0), value(NAN), zero_value(0), decay(1) {}
+
+        __attribute__((__always_inline__)) inline void
+        push(double x)
+        {
+            if (isnan(x)){
+                return;
+            }
+            value = n ? beta_1sub * value + beta * x : x;
+            zero_value = beta_1sub * zero_value + beta * x;
+            decay *= beta_1sub;
+            n += 1;
+        }
+
+        /**
+         * @brief 把紧接在当前这段数之后的一段数的状态并入，两者的 span 须相同
+         */
+        __attribute__((__always_inline__)) inline void
+        merge(const ONLINE_EMA &later)
+        {
+            if (later.n == 0){
+                return;
+            }
+            if (n == 0){
+                *this = later;
+                return;
+            }
+            value = later.decay * value + later.zero_value;
+            zero_value = later.decay * zero_value + later.zero_value;
+            decay *= later.decay;
+            n += later.n;
+        }
+
+        __attribute__((__always_inline__)) inline size_t
+        count() const
+        {
+            return n;
+        }
+
+        __attribute__((__always_inline__)) inline double
+        ema() const
+        {
+            return value;
+        }
+    };
+
+
+    /**
+     * @brief ONLINE_MOMENTS 的 8 个品种版本，每个 lane 一个品种
+     */
+    struct ONLINE_MOMENTS_X8
+    {
+        __m512d n, mu, m2, m3, m4;   // 个数、均值与 2~4 阶中心矩之和，同 moments
+
+        ONLINE_MOMENTS_X8()
+        {
+            n = mu = m2 = m3 = m4 = _mm512_setzero_pd();
+        }
+
+        /**
+         * @brief 加入 8 个品种在同一时刻的值，NaN 被忽略
+         */
+        __attribute__((__always_inline__)) inline void
+        push(__m512d x)
+        {
+            __mmask8 valid = avx_valid_mask(x);
+            const __m512d avx_zero = _mm512_setzero_pd();
+            avx_moments_merge(n, mu, m2, m3, m4, _mm512_maskz_mov_pd(valid, _mm512_set1_pd(1)),
+                            _mm512_maskz_mov_pd(valid, x), avx_zero, avx_zero, avx_zero);
+        }
+
+        __attribute__((__always_inline__)) inline void
+        push(const double *x)
+        {
+            push(_mm512_loadu_pd(x));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        merge(const ONLINE_MOMENTS_X8 &other)
+        {
+            avx_moments_merge(n, mu, m2, m3, m4, other.n, other.mu, other.m2, other.m3, other.m4);
+        }
+
+        /**
+         * @brief 各品种的个数（double 表示）
+         */
+        __attribute__((__always_inline__)) inline void
+        count(double *out) const
+        {
+            _mm512_storeu_pd(out, n);
+        }
+
+        __attribute__((__always_inline__)) inline void
+        mean(double *out) const
+        {
+            _mm512_storeu_pd(out, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(n, _mm512_setzero_pd(), _CMP_EQ_OQ),
+                                                        mu, _mm512_set1_pd(NAN)));
+        }
+
+        __attribute__((__always_inline__)) inline __m512d
+        avx_var(bool bias) const
+        {
+            __m512d res = _mm512_div_pd(m2, _mm512_sub_pd(n, _mm512_set1_pd(bias ? 0 : 1)));
+            return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(n, _mm512_setzero_pd(), _CMP_EQ_OQ),
+                                        res, _mm512_set1_pd(NAN));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        var(bool bias, double *out) const
+        {
+            _mm512_storeu_pd(out, avx_var(bias));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        std(bool bias, double *out) const
+        {
+            _mm512_storeu_pd(out, _mm512_sqrt_pd(avx_var(bias)));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        skew(double *out) const
+        {
+            __m512d m2_pow3 = _mm512_mul_pd(_mm512_mul_pd(m2, m2), m2);
+            _mm512_storeu_pd(out, _mm512_div_pd(m3, _mm512_sqrt_pd(_mm512_div_pd(m2_pow3, n))));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        kurt(double *out) const
+        {
+            _mm512_storeu_pd(out, _mm512_div_pd(_mm512_mul_pd(n, m4), _mm512_mul_pd(m2, m2)));
+        }
+    };
+
+
+    /**
+     * @brief ONLINE_COVAR 的 8 个品种版本，每个 lane 一个品种
+     */
+    struct ONLINE_COVAR_X8
+    {
+        __m512d n, x_mean, y_mean, sxx, syy, sxy;
+
+        ONLINE_COVAR_X8()
+        {
+            n = x_mean = y_mean = sxx = syy = sxy = _mm512_setzero_pd();
+        }
+
+        __attribute__((__always_inline__)) inline void
+        push(__m512d x, __m512d y)
+        {
+            __mmask8 valid = avx_valid_mask(_mm512_mul_pd(x, y));
+            n = _mm512_mask_add_pd(n, valid, n, _mm512_set1_pd(1));
+            __m512d dx = _mm512_maskz_sub_pd(valid, x, x_mean), dy = _mm512_maskz_sub_pd(valid, y, y_mean);
+            x_mean = _mm512_add_pd(x_mean, _mm512_maskz_div_pd(valid, dx, n));
+            y_mean = _mm512_add_pd(y_mean, _mm512_maskz_div_pd(valid, dy, n));
+            __m512d ex = _mm512_maskz_sub_pd(valid, x, x_mean), ey = _mm512_maskz_sub_pd(valid, y, y_mean);
+            sxx = _mm512_fmadd_pd(dx, ex, sxx);
+            syy = _mm512_fmadd_pd(dy, ey, syy);
+            sxy = _mm512_fmadd_pd(dx, ey, sxy);
+        }
+
+        __attribute__((__always_inline__)) inline void
+        push(const double *x, const double *y)
+        {
+            push(_mm512_loadu_pd(x), _mm512_loadu_pd(y));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        merge(const ONLINE_COVAR_X8 &other)
+        {
+            __m512d total = _mm512_add_pd(n, other.n);
+            __mmask8 nonzero = _mm512_cmp_pd_mask(total, _mm512_setzero_pd(), _CMP_NEQ_OQ);
+            __m512d dx = _mm512_sub_pd(other.x_mean, x_mean), dy = _mm512_sub_pd(other.y_mean, y_mean);
+            __m512d w = _mm512_maskz_div_pd(nonzero, _mm512_mul_pd(n, other.n), total);
+            __m512d nb_n = _mm512_maskz_div_pd(nonzero, other.n, total);
+            sxx = _mm512_add_pd(_mm512_add_pd(sxx, other.sxx), _mm512_mul_pd(_mm512_mul_pd(dx, dx), w));
+            syy = _mm512_add_pd(_mm512_add_pd(syy, other.syy), _mm512_mul_pd(_mm512_mul_pd(dy, dy), w));
+            sxy = _mm512_add_pd(_mm512_add_pd(sxy, other.sxy), _mm512_mul_pd(_mm512_mul_pd(dx, dy), w));
+            x_mean = _mm512_fmadd_pd(dx, nb_n, x_mean);
+            y_mean = _mm512_fmadd_pd(dy, nb_n, y_mean);
+            n = total;
+        }
+
+        __attribute__((__always_inline__)) inline void
+        count(double *out) const
+        {
+            _mm512_storeu_pd(out, n);
+        }
+
+        __attribute__((__always_inline__)) inline void
+        covar(bool bias, double *out) const
+        {
+            __m512d res = _mm512_div_pd(sxy, _mm512_sub_pd(n, _mm512_set1_pd(bias ? 0 : 1)));
+            _mm512_storeu_pd(out, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(n, _mm512_setzero_pd(), _CMP_EQ_OQ),
+                                                        res, _mm512_set1_pd(NAN)));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        corr(double *out) const
+        {
+            _mm512_storeu_pd(out, _mm512_div_pd(sxy, _mm512_sqrt_pd(_mm512_mul_pd(sxx, syy))));
+        }
+
+        __attribute__((__always_inline__)) inline void
+        beta(double *out) const
+        {
+            _mm512_storeu_pd(out, _mm512_div_pd(sxy, sxx));
+        }
+    };
+
+
+    typedef ONLINE_COVAR_X8 ONLINE_BETA_X8;
+
+
+    /**
+     * @brief ONLINE_EMA 的 8 个品种版本，每个 lane 一个品种，span 相同
+     */
+    struct ONLINE_EMA_X8
+    {
+        __m512d beta, beta_1sub;
+        __m512d value, zero_value, decay;
+
+        explicit ONLINE_EMA_X8(double span)
+        {
+            double alpha = 2 / (span + 1);
+            beta = _mm512_set1_pd(alpha);
+            beta_1sub = _mm512_set1_pd(1 - alpha);
+            value = _mm512_set1_pd(NAN);
+            zero_value = _mm512_setzero_pd();
+            decay = _mm512_set1_pd(1);
+        }
+
+        __attribute__((__always_inline__)) inline void
+        push(__m512d x)
+        {
+            __mmask8 valid = avx_valid_mask(x);
+            // 还没有值的 lane 直接取第一个非 NaN 的数
+            __mmask8 first = _mm512_mask_cmp_pd_mask(valid, value, value, _CMP_UNORD_Q);
+            __m512d avx_tmp = _mm512_mul_pd(x, beta);
+            value = _mm512_mask_fmadd_pd(value, valid, beta_1sub, avx_tmp);
+            value = _mm512_mask_mov_pd(value, first, x);
+            zero_value = _mm512_mask_fmadd_pd(zero_value, valid, beta_1sub, avx_tmp);
+            decay = _mm512_mask_mul_pd(decay, valid, decay, beta_1sub);
+        }
+
+        __attribute__((__always_inline__)) inline void
+        push(const double *x)
+        {
+            push(_mm512_loadu_pd(x));
+        }
+
+        /**
+         * @brief 把紧接在当前这段数之后的一段数的状态并入，见 ONLINE_EMA::merge
+         */
+        __attribute__((__always_inline__)) inline void
+        merge(const ONLINE_EMA_X8 &later)
+        {
+            // later 为空的 lane：decay = 1、zero_value = 0，value 不变；当前为空的 lane 取 later 的值
+            __mmask8 empty = _mm512_cmp_pd_mask(value, value, _CMP_UNORD_Q);
+            value = _mm512_mask_blend_pd(empty, _mm512_fmadd_pd(later.decay, value, later.zero_value), later.value);
+            zero_value = _mm512_fmadd_pd(later.decay, zero_value, later.zero_value);
+            decay = _mm512_mul_pd(decay, later.decay);
+        }
+
+        __attribute__((__always_inline__)) inline void
+        ema(double *out) const
+        {
+            _mm512_storeu_pd(out, value);
+        }
+    };
+};
+
+#pragma GCC pop_options
+
+#endif
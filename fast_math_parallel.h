@@ -0,0 +1,492 @@
+#ifndef FAST_MATH_PARALLEL_H
+#define FAST_MATH_PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+#include <immintrin.h>
+#include <math.h>
+#include <string.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "fast_math.h"
+#include "fast_math_online.h"
+#include "fast_math_numa.h"
+
+
+// FAST_MATH 的多线程归约：把很长的数组按 PARALLEL_CHUNK 个数切成固定的块，由线程池分头计算每块的部分结果，
+// 再按块的顺序依次合并（sum 直接相加，var 等用 moments_merge，covar 等用 ONLINE_COVAR::merge）。
+// 块的划分与合并顺序只取决于数组长度，与线程数、调度顺序无关，因此结果逐位可复现；
+// 长度不超过一块时直接调用单线程版本。
+// 线程由 parallel_pool() 在第一次使用时创建，会继承当时的 CPU 亲和性：
+// 如果要用 sched_setaffinity 绑定主线程，应先调用 parallel_pool()。
+// 多个 NUMA 节点时，工作线程分别绑定到各节点，块按节点切成连续的几段，各节点优先处理自己那一段；
+// 用 parallel_alloc 分配的数组按同样的切分初始化，每段内存落在处理它的节点上
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512cd,avx512bw,avx512vl,fma,popcnt")
+
+namespace FAST_MATH
+{
+    static const size_t PARALLEL_CHUNK = 1 << 16;   // 512KB，放得进 L2
+
+
+    /**
+     * @brief 线程池：run(nTasks, func) 让所有线程（包括调用者）领取 0 ~ nTasks-1 的任务，全部完成后返回。func 中不能再调用 run。
+     *        有多个 NUMA 节点时，第 s 个线程（调用者为第 0 个）绑定到第 s % nNodes 个节点，
+     *        任务按各节点的线程数切成连续的几段，线程先领取本节点那一段，做完再去帮其他节点；
+     *        切分只取决于 nTasks 与线程数，parallel_first_touch 按同样的切分初始化内存，之后的计算大多读本节点的内存
+     */
+    struct PARALLEL_POOL
+    {
+        // 一个节点的任务段 [next, end)
+        struct alignas(64) NODE_RANGE
+        {
+            std::atomic<size_t> next;
+            size_t end;
+        };
+
+        std::vector<std::thread> workers;
+        std::mutex run_mutex, mutex;
+        std::condition_variable wake, finished;
+        std::function<void(size_t)> job;
+        std::vector<int> cpu_node, node_ids;
+        std::vector<NODE_RANGE> ranges;
+        size_t n_nodes, generation, reported;
+        bool stop;
+
+        explicit PARALLEL_POOL(size_t nThreads) : cpu_node(numa_cpu_nodes()), node_ids(numa_nodes()), ranges(node_ids.size()),
+            n_nodes(ranges.size()), generation(0), reported(0), stop(false)
+        {
+            start(nThreads);
+        }
+
+        ~PARALLEL_POOL()
+        {
+            shutdown();
+        }
+
+        PARALLEL_POOL(const PARALLEL_POOL &) = delete;
+        PARALLEL_POOL &operator=(const PARALLEL_POOL &) = delete;
+
+        /**
+         * @brief 线程总数，包括调用 run 的线程
+         */
+        size_t size() const
+        {
+            return workers.size() + 1;
+        }
+
+        /**
+         * @brief 改变线程总数（至少为 1）
+         */
+        void resize(size_t nThreads)
+        {
+            std::lock_guard<std::mutex> run_lock(run_mutex);
+            shutdown();
+            start(nThreads);
+        }
+
+        template <typename FUNC>
+        void run(size_t nTasks, FUNC func)
+        {
+            std::lock_guard<std::mutex> run_lock(run_mutex);
+            if (workers.empty() || nTasks <= 1){
+                for (size_t i = 0; i != nTasks; ++i){
+                    func(i);
+                }
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = func;
+                for (size_t node = 0; node != n_nodes; ++node){
+                    ranges[node].next = node ? ranges[node-1].end : 0;
+                    ranges[node].end = range_end(node, nTasks);
+                }
+                reported = 0;
+                ++generation;
+            }
+            wake.notify_all();
+            // 调用者不绑定，按它当前所在的节点领取
+            int cpu = sched_getcpu();
+            execute(cpu >= 0 && (size_t)cpu < cpu_node.size() ? cpu_node[cpu] : 0);
+            // 等所有线程都确认过这一轮，之后才能修改 job
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this]{ return reported == workers.size(); });
+        }
+
+    private:
+        /**
+         * @brief 第 node 个节点任务段的结尾：按线程 s -> 节点 s % n_nodes 的线程数比例切分
+         */
+        size_t range_end(size_t node, size_t nTasks) const
+        {
+            size_t nThreads = size(), threads = 0;
+            for (size_t k = 0; k <= node; ++k){
+                threads += nThreads / n_nodes + (k < nThreads % n_nodes);
+            }
+            return nTasks * threads / nThreads;
+        }
+
+        void start(size_t nThreads)
+        {
+            stop = false;
+            // 新线程从当前这一轮之后开始等待，不能在线程内读取 generation：run 可能已经开始了新的一轮
+            size_t seen = generation;
+            for (size_t i = 1; i < nThreads; ++i){
+                size_t node = i % n_nodes;
+                workers.emplace_back([this, seen, node]{ work(seen, node); });
+                if (n_nodes > 1){
+                    pin_thread(workers.back().native_handle(), numa_node_cpus(node_ids[node]));
+                }
+            }
+        }
+
+        void shutdown()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for (std::thread &worker : workers){
+                worker.join();
+            }
+            workers.clear();
+        }
+
+        void execute(size_t node)
+        {
+            for (size_t k = 0; k != n_nodes; ++k){
+                NODE_RANGE &range = ranges[(node + k) % n_nodes];
+                for (size_t i = range.next++; i < range.end; i = range.next++){
+                    job(i);
+                }
+            }
+        }
+
+        void work(size_t seen, size_t node)
+        {
+            for (;;){
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]{ return stop || generation != seen; });
+                    if (stop){
+                        return;
+                    }
+                    seen = generation;
+                }
+                execute(node);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (++reported == workers.size()){
+                    finished.notify_one();
+                }
+            }
+        }
+    };
+
+
+    /**
+     * @brief 全局线程池，第一次调用时按 CPU 核数创建
+     */
+    inline PARALLEL_POOL &
+    parallel_pool()
+    {
+        static PARALLEL_POOL pool(std::thread::hardware_concurrency());
+        return pool;
+    }
+
+
+    /**
+     * @brief 设置全局线程池的线程数，不影响结果
+     */
+    inline void
+    set_num_threads(size_t nThreads)
+    {
+        parallel_pool().resize(nThreads);
+    }
+
+
+    /**
+     * @brief 按 parallel_reduce 的分块由线程池把 data 置 0：在默认的 first-touch 策略下，每一页分配在第一次写它的线程所在的节点上，
+     *        即之后多线程计算时处理这一块的节点。分块与数组长度、线程数有关，应与之后计算时一致
+     */
+    inline void
+    parallel_first_touch(double *data, size_t nLength)
+    {
+        size_t nChunks = (nLength + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+        parallel_pool().run(nChunks, [=](size_t c){
+            size_t begin = c * PARALLEL_CHUNK;
+            memset(data + begin, 0, sizeof(double) * (nLength - begin < PARALLEL_CHUNK ? nLength - begin : PARALLEL_CHUNK));
+        });
+    }
+
+
+    /**
+     * @brief 分配 nLength 个 double 并用 parallel_first_touch 置 0，用于交给 parallel_* 处理的大数组；
+     *        用 mmap 分配，起始地址按页对齐，块的边界都在页的边界上。失败时返回 NULL，用 parallel_free 释放
+     */
+    inline double *
+    parallel_alloc(size_t nLength)
+    {
+        void *data = mmap(NULL, sizeof(double) * (nLength ? nLength : 1), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED){
+            return NULL;
+        }
+        parallel_first_touch((double *)data, nLength);
+        return (double *)data;
+    }
+
+
+    /**
+     * @brief 释放 parallel_alloc 分配的数组，nLength 与分配时相同
+     */
+    inline void
+    parallel_free(double *data, size_t nLength)
+    {
+        if (data != NULL){
+            munmap(data, sizeof(double) * (nLength ? nLength : 1));
+        }
+    }
+
+
+    /**
+     * @brief 并行归约：res = merge(...merge(merge(init, chunk(块 0)), chunk(块 1))..., chunk(块 n-1))，
+     *        chunk(const double *data 中的偏移, size_t 长度) 在线程池中计算，merge 按块的顺序在调用线程中执行
+     */
+    template <typename RESULT, typename CHUNK_FUNC, typename MERGE_FUNC>
+    inline RESULT
+    parallel_reduce(size_t nLength, RESULT init, CHUNK_FUNC chunk, MERGE_FUNC merge)
+    {
+        size_t nChunks = (nLength + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+        RESULT *partial = new RESULT[nChunks];
+        parallel_pool().run(nChunks, [&](size_t c){
+            size_t begin = c * PARALLEL_CHUNK;
+            partial[c] = chunk(begin, nLength - begin < PARALLEL_CHUNK ? nLength - begin : PARALLEL_CHUNK);
+        });
+        RESULT res = init;
+        for (size_t c = 0; c != nChunks; ++c){
+            res = merge(res, partial[c]);
+        }
+        delete[] partial;
+        return res;
+    }
+
+
+    /**
+     * @brief 多线程求和，见 sum
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_sum(const double *data, size_t nLength)
+    {
+        if (nLength <= PARALLEL_CHUNK){
+            return sum<NAN_POLICY>(data, nLength);
+        }
+        return parallel_reduce(nLength, 0.0,
+            [=](size_t begin, size_t len){ return sum<NAN_POLICY>(data + begin, len); },
+            [](double a, double b){ return a + b; });
+    }
+
+
+    /**
+     * @brief 多线程求平均，见 mean
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_mean(const double *data, size_t nLength)
+    {
+        if (nLength <= PARALLEL_CHUNK){
+            return mean<NAN_POLICY>(data, nLength);
+        }
+        struct sum_count { double sum; size_t count; };
+        sum_count res = parallel_reduce(nLength, sum_count{0, 0},
+            [=](size_t begin, size_t len){
+                sum_count part;
+                part.sum = sum_len<NAN_POLICY>(data + begin, len, &part.count);
+                return part;
+            },
+            [](sum_count a, sum_count b){ return sum_count{a.sum + b.sum, a.count + b.count}; });
+        return res.sum / res.count;
+    }
+
+
+    /**
+     * @brief 多线程求 moments（个数、均值与 2~4 阶中心矩），见 calc_moments
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline moments
+    parallel_moments(const double *data, size_t nLength)
+    {
+        if (nLength <= PARALLEL_CHUNK){
+            return calc_moments<NAN_POLICY>(data, nLength);
+        }
+        moments init = {0, 0, 0, 0, 0};
+        return parallel_reduce(nLength, init,
+            [=](size_t begin, size_t len){ return calc_moments<NAN_POLICY>(data + begin, len); },
+            [](const moments &a, const moments &b){ return moments_merge(a, b); });
+    }
+
+
+    /**
+     * @brief 多线程求方差，见 var
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_var(const double *data, size_t nLength, bool bias)
+    {
+        return moments_var(parallel_moments<NAN_POLICY>(data, nLength), bias);
+    }
+
+
+    /**
+     * @brief 多线程求标准差，见 std
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_std(const double *data, size_t nLength, bool bias)
+    {
+        return sqrt(parallel_var<NAN_POLICY>(data, nLength, bias));
+    }
+
+
+    /**
+     * @brief 多线程求最小值，见 min
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_min(const double *data, size_t nLength)
+    {
+        if (nLength <= PARALLEL_CHUNK){
+            return min<NAN_POLICY>(data, nLength);
+        }
+        return parallel_reduce(nLength, (double)INFINITY,
+            [=](size_t begin, size_t len){ return min<NAN_POLICY>(data + begin, len); },
+            [](double a, double b){ return isnan(a) || a < b ? a : b; });
+    }
+
+
+    /**
+     * @brief 多线程求最大值，见 max
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_max(const double *data, size_t nLength)
+    {
+        if (nLength <= PARALLEL_CHUNK){
+            return max<NAN_POLICY>(data, nLength);
+        }
+        return parallel_reduce(nLength, -(double)INFINITY,
+            [=](size_t begin, size_t len){ return max<NAN_POLICY>(data + begin, len); },
+            [](double a, double b){ return isnan(a) || a > b ? a : b; });
+    }
+
+
+    /**
+     * @brief 块内的最值与其索引，索引为 (size_t)-1 表示整块都是 NaN
+     */
+    struct value_index
+    {
+        double value;
+        size_t index;
+    };
+
+
+    /**
+     * @brief 多线程求最小值的索引，见 imin；不同块的最小值相等时取靠前的块
+     */
+    inline size_t
+    parallel_imin(const double *data, size_t nLength)
+    {
+        if (nLength <= PARALLEL_CHUNK){
+            return imin(data, nLength);
+        }
+        value_index init = {INFINITY, (size_t)-1};
+        return parallel_reduce(nLength, init,
+            [=](size_t begin, size_t len){
+                // 块内全是 NaN 时 imin 返回的索引不在块内，不能拿来读数
+                size_t index = imin(data + begin, len);
+                return index >= len ? value_index{INFINITY, (size_t)-1} : value_index{data[begin + index], begin + index};
+            },
+            [](const value_index &a, const value_index &b){ return b.value < a.value ? b : a; }).index;
+    }
+
+
+    /**
+     * @brief 多线程求最大值的索引，见 imax；不同块的最大值相等时取靠前的块
+     */
+    inline size_t
+    parallel_imax(const double *data, size_t nLength)
+    {
+        if (nLength <= PARALLEL_CHUNK){
+            return imax(data, nLength);
+        }
+        value_index init = {-INFINITY, (size_t)-1};
+        return parallel_reduce(nLength, init,
+            [=](size_t begin, size_t len){
+                // 块内全是 NaN 时 imax 返回的索引不在块内，不能拿来读数
+                size_t index = imax(data + begin, len);
+                return index >= len ? value_index{-INFINITY, (size_t)-1} : value_index{data[begin + index], begin + index};
+            },
+            [](const value_index &a, const value_index &b){ return b.value > a.value ? b : a; }).index;
+    }
+
+
+    /**
+     * @brief 多线程求两组数的 ONLINE_COVAR 状态（个数、均值、离差平方和与离差积和），见 calc_comoments
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline ONLINE_COVAR
+    parallel_comoments(const double *x_data, const double *y_data, size_t nLength)
+    {
+        if (nLength <= PARALLEL_CHUNK){
+            return calc_comoments<NAN_POLICY>(x_data, y_data, nLength);
+        }
+        return parallel_reduce(nLength, ONLINE_COVAR(),
+            [=](size_t begin, size_t len){ return calc_comoments<NAN_POLICY>(x_data + begin, y_data + begin, len); },
+            [](ONLINE_COVAR a, const ONLINE_COVAR &b){ a.merge(b); return a; });
+    }
+
+
+    /**
+     * @brief 多线程求两组数的协方差，见 covar
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_covar(const double *x_data, const double *y_data, size_t nLength, bool bias)
+    {
+        return parallel_comoments<NAN_POLICY>(x_data, y_data, nLength).covar(bias);
+    }
+
+
+    /**
+     * @brief 多线程求两组数的相关系数，见 corr
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_corr(const double *x_data, const double *y_data, size_t nLength)
+    {
+        return parallel_comoments<NAN_POLICY>(x_data, y_data, nLength).corr();
+    }
+
+
+    /**
+     * @brief 多线程求 y 对 x 回归的 beta，见 beta
+     */
+    template <typename NAN_POLICY = SKIP_NAN>
+    inline double
+    parallel_beta(const double *x_data, const double *y_data, size_t nLength)
+    {
+        return parallel_comoments<NAN_POLICY>(x_data, y_data, nLength).beta();
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,820 @@
+#ifndef FAST_MATH_ROLLING_H
+#define FAST_MATH_ROLLING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+#include <immintrin.h>
+#include <math.h>
+#include "fast_math.h"
+
+
+// FAST_MATH 的滚动窗口统计：
+// out[i] 为 data[i-window+1 .. i]（开头不足 window 个时为 data[0 .. i]）的统计量，忽略 NaN，
+// 窗口内非 NaN 的个数少于 min_periods（至少为 1）时 out[i] 为 NaN。
+// 每个窗口的统计量都由窗口内平移后的幂和 sum((x-shift)^k) 算出，
+// 幂和随窗口移动只需加上新进入、减去移出窗口的数：
+// 每次处理 8 个位置，先算出 8 个位置各自的增量，再在寄存器内做前缀和，因此整个数组是 O(N) 的。
+// 为了限制累加误差，每隔 anchor_len 个位置以当前窗口的均值为新的平移量重新计算一次幂和
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512cd,avx512bw,avx512vl,fma,popcnt")
+
+namespace FAST_MATH
+{
+    /**
+     * @brief 8 个 lane 的前缀和（包含本 lane），再加上 carry
+     * @param x __m512d
+     * @param carry 前面所有 lane 的和（8 个 lane 相同）
+     * @return 前缀和
+     */
+    __attribute__((__always_inline__)) inline __m512d
+    avx_prefix_sum(__m512d x, __m512d carry)
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        x = _mm512_add_pd(x, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(x), zero, 7)));
+        x = _mm512_add_pd(x, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(x), zero, 6)));
+        x = _mm512_add_pd(x, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(x), zero, 4)));
+        return _mm512_add_pd(x, carry);
+    }
+
+
+    /**
+     * @brief 把最后一个 lane 广播到 8 个 lane，作为下一组的 carry
+     */
+    __attribute__((__always_inline__)) inline __m512d
+    avx_last_lane(__m512d x)
+    {
+        return _mm512_permutexvar_pd(_mm512_set1_epi64(7), x);
+    }
+
+
+    /**
+     * @brief 重新计算平移量与幂和的间隔，为 8 的倍数，且不小于窗口长度的 4 倍，
+     *        使重新计算的开销不超过总开销的 1/4
+     */
+    __attribute__((__always_inline__)) inline size_t
+    rolling_anchor_len(size_t window)
+    {
+        size_t anchor_len = window * 4 > 1024 ? window * 4 : 1024;
+        return (anchor_len + 7) & ~(size_t)0x7;
+    }
+
+
+    /**
+     * @brief 读取 index 起 8 个位置各自移出窗口的数，即 data[index-window .. index-window+7]，
+     *        不存在的位置（index+i < window）对应的 lane 为 0，且不在返回的 mask 中
+     */
+    __attribute__((__always_inline__)) inline __m512d
+    rolling_load_old(const double *data, size_t index, size_t window, __mmask8 &mask)
+    {
+        if (index >= window){
+            return _mm512_maskz_loadu_pd(mask, data+index-window);
+        }
+        if (window - index >= 8){
+            mask = 0;
+            return _mm512_setzero_pd();
+        }
+        // 第 window-index 个 lane 起依次是 data[0], data[1], ...
+        mask &= ~((1 << (window - index)) - 1);
+        return _mm512_maskz_expandloadu_pd(mask, data);
+    }
+
+
+    /**
+     * @brief 与 pandas 一样记录连续相等的非 NaN 数的个数：窗口内的数全部相等时，
+     *        平移后的幂和带有之前的数留下的累加误差，算出的方差不一定恰好为 0，此时由调用方把幂和置 0
+     * @param x 8 个位置的数
+     * @param valid x 中不是 NaN 的 lane
+     * @param last 之前最后一个非 NaN 的数（8 个 lane 相同，还没有时为 NaN），返回时更新为本组的
+     * @param run 之前连续等于 last 的非 NaN 数的个数（8 个 lane 相同），返回时更新为本组的
+     * @return 每个位置截至该处连续相等的非 NaN 数的个数
+     */
+    __attribute__((__always_inline__)) inline __m512d
+    avx_rolling_run(__m512d x, __mmask8 valid, __m512d &last, __m512d &run)
+    {
+        const __m512d avx_one = _mm512_set1_pd(1);
+        // 向后填充：filled[i] 为 i 处及之前最后一个非 NaN 的数
+        __m512d filled = _mm512_mask_mov_pd(last, valid, x);
+        __mmask8 done = valid;
+        filled = _mm512_mask_mov_pd(filled, ~done, _mm512_castsi512_pd(_mm512_alignr_epi64(
+                                    _mm512_castpd_si512(filled), _mm512_castpd_si512(last), 7)));
+        done |= (done << 1) | 0x1;
+        filled = _mm512_mask_mov_pd(filled, ~done, _mm512_castsi512_pd(_mm512_alignr_epi64(
+                                    _mm512_castpd_si512(filled), _mm512_castpd_si512(last), 6)));
+        done |= (done << 2) | 0x3;
+        filled = _mm512_mask_mov_pd(filled, ~done, _mm512_castsi512_pd(_mm512_alignr_epi64(
+                                    _mm512_castpd_si512(filled), _mm512_castpd_si512(last), 4)));
+        __m512d prev = _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(filled), _mm512_castpd_si512(last), 7));
+        __mmask8 change = valid & _mm512_cmp_pd_mask(x, prev, _CMP_NEQ_UQ);
+
+        // count[i] 为本组截至 i 处的非 NaN 个数，base 为最近一次变化之前的个数（没有变化时为 -run），前缀最大值求出
+        __m512d count = avx_prefix_sum(_mm512_maskz_mov_pd(valid, avx_one), _mm512_setzero_pd());
+        __m512d init = _mm512_sub_pd(_mm512_setzero_pd(), run);
+        __m512d base = _mm512_mask_sub_pd(init, change, count, avx_one);
+        base = _mm512_max_pd(base, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(base), _mm512_castpd_si512(init), 7)));
+        base = _mm512_max_pd(base, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(base), _mm512_castpd_si512(init), 6)));
+        base = _mm512_max_pd(base, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(base), _mm512_castpd_si512(init), 4)));
+        __m512d res = _mm512_sub_pd(count, base);
+
+        last = avx_last_lane(filled);
+        run = avx_last_lane(res);
+        return res;
+    }
+
+
+    /**
+     * @brief 单个数组的滚动统计共用的内核
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内至少要有多少个非 NaN 的数
+     * @param out 输出数组，长度为 nLength
+     * @param avx_output (n, s1, s2, s3, s4, shift) -> __m512d，由窗口内非 NaN 的个数 n
+     *                   与平移后的幂和 sk = sum((x-shift)^k) 计算统计量；ORDER 以上的幂和为 0，
+     *                   ORDER >= 2 时窗口内的数全部相等的位置 s1 ~ s4 都为 0
+     */
+    template <int ORDER, typename AVX_OUTPUT>
+    __attribute__((__always_inline__)) inline void
+    rolling_moments(const double *data, size_t nLength, size_t window, size_t min_periods,
+                    double *out, AVX_OUTPUT avx_output)
+    {
+        const size_t anchor_len = rolling_anchor_len(window);
+        const __m512d avx_one = _mm512_set1_pd(1), avx_nan = _mm512_set1_pd(NAN),
+                    avx_min_periods = _mm512_set1_pd(min_periods > 1 ? min_periods : 1);
+        double shift = 0, n = 0, s1 = 0, s2 = 0, s3 = 0, s4 = 0;
+        __m512d avx_last = avx_nan, avx_run = _mm512_setzero_pd();
+
+        for (size_t begin = 0; begin < nLength; begin += anchor_len){
+            size_t end = nLength - begin > anchor_len ? begin + anchor_len : nLength, i;
+            size_t window_begin = begin > window ? begin - window : 0;
+
+            // 以当前窗口的均值为新的平移量；窗口内还没有数时，取之后第一个非 NaN 的数
+            if (n != 0){
+                shift += s1 / n;
+            }
+            else{
+                for (i = begin; i != end && isnan(data[i]); ++i);
+                shift = i != end ? data[i] : 0;
+            }
+            n = s1 = s2 = s3 = s4 = 0;
+            for (i = window_begin; i != begin; ++i){
+                if (!isnan(data[i])){
+                    double d = data[i] - shift, d2 = d * d;
+                    n += 1;
+                    s1 += d;
+                    s2 += d2;
+                    s3 += d2 * d;
+                    s4 += d2 * d2;
+                }
+            }
+
+            __m512d avx_shift = _mm512_set1_pd(shift), avx_n = _mm512_set1_pd(n),
+                    avx_s1 = _mm512_set1_pd(s1), avx_s2 = _mm512_set1_pd(s2),
+                    avx_s3 = _mm512_set1_pd(s3), avx_s4 = _mm512_set1_pd(s4),
+                    avx_new, avx_old, d_new, d_old, d2_new, d2_old, avx_res;
+            __mmask8 mask, valid_new, valid_old;
+
+            for (size_t index = begin; index < end; index += 8){
+                mask = end - index >= 8 ? 0xff : (1 << (end - index)) - 1;
+                avx_new = _mm512_maskz_loadu_pd(mask, data+index);
+                valid_old = mask;
+                avx_old = rolling_load_old(data, index, window, valid_old);
+                valid_new = avx_valid_mask(avx_new) & mask;
+                valid_old = avx_valid_mask(avx_old) & valid_old;
+
+                d_new = _mm512_maskz_sub_pd(valid_new, avx_new, avx_shift);
+                d_old = _mm512_maskz_sub_pd(valid_old, avx_old, avx_shift);
+                avx_n = avx_prefix_sum(_mm512_sub_pd(_mm512_maskz_mov_pd(valid_new, avx_one),
+                                                    _mm512_maskz_mov_pd(valid_old, avx_one)), avx_n);
+                avx_s1 = avx_prefix_sum(_mm512_sub_pd(d_new, d_old), avx_s1);
+                if (ORDER >= 2){
+                    d2_new = _mm512_mul_pd(d_new, d_new);
+                    d2_old = _mm512_mul_pd(d_old, d_old);
+                    avx_s2 = avx_prefix_sum(_mm512_sub_pd(d2_new, d2_old), avx_s2);
+                }
+                if (ORDER >= 3){
+                    avx_s3 = avx_prefix_sum(_mm512_fmsub_pd(d2_new, d_new, _mm512_mul_pd(d2_old, d_old)), avx_s3);
+                }
+                if (ORDER >= 4){
+                    avx_s4 = avx_prefix_sum(_mm512_fmsub_pd(d2_new, d2_new, _mm512_mul_pd(d2_old, d2_old)), avx_s4);
+                }
+
+                if (ORDER >= 2){
+                    __mmask8 varying = _mm512_cmp_pd_mask(avx_rolling_run(avx_new, valid_new, avx_last, avx_run),
+                                                        avx_n, _CMP_LT_OQ);
+                    avx_res = avx_output(avx_n, _mm512_maskz_mov_pd(varying, avx_s1), _mm512_maskz_mov_pd(varying, avx_s2),
+                                        _mm512_maskz_mov_pd(varying, avx_s3), _mm512_maskz_mov_pd(varying, avx_s4), avx_shift);
+                }
+                else{
+                    avx_res = avx_output(avx_n, avx_s1, avx_s2, avx_s3, avx_s4, avx_shift);
+                }
+                avx_res = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(avx_n, avx_min_periods, _CMP_LT_OQ),
+                                            avx_res, avx_nan);
+                _mm512_mask_storeu_pd(out+index, mask, avx_res);
+
+                avx_n = avx_last_lane(avx_n);
+                avx_s1 = avx_last_lane(avx_s1);
+                avx_s2 = avx_last_lane(avx_s2);
+                avx_s3 = avx_last_lane(avx_s3);
+                avx_s4 = avx_last_lane(avx_s4);
+            }
+            // 最后一组不满 8 个时，最后一个 lane 不是 end-1 处的值，但此时已经是数组末尾，不再使用
+            n = _mm512_cvtsd_f64(avx_n);
+            s1 = _mm512_cvtsd_f64(avx_s1);
+        }
+    }
+
+
+    /**
+     * @brief 两个数组的滚动统计共用的内核，若某组数某处为 NaN，则两组数的该位置都被忽略
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内至少要有多少对非 NaN 的数
+     * @param out 输出数组，长度为 nLength
+     * @param avx_output (n, sx, sy, sxx, syy, sxy) -> __m512d，由窗口内的对数 n
+     *                   与平移后的和 sx = sum(x-x_shift)、sxy = sum((x-x_shift)*(y-y_shift)) 等计算统计量；
+     *                   窗口内 x 全部相等的位置 sx、sxx、sxy 为 0，y 全部相等的位置 sy、syy、sxy 为 0
+     */
+    template <typename AVX_OUTPUT>
+    __attribute__((__always_inline__)) inline void
+    rolling_comoments(const double * __restrict__ x_data, const double * __restrict__ y_data,
+                    size_t nLength, size_t window, size_t min_periods,
+                    double * __restrict__ out, AVX_OUTPUT avx_output)
+    {
+        const size_t anchor_len = rolling_anchor_len(window);
+        const __m512d avx_one = _mm512_set1_pd(1), avx_nan = _mm512_set1_pd(NAN),
+                    avx_min_periods = _mm512_set1_pd(min_periods > 1 ? min_periods : 1);
+        double x_shift = 0, y_shift = 0, n = 0, sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+        __m512d x_last = avx_nan, y_last = avx_nan, x_run = _mm512_setzero_pd(), y_run = _mm512_setzero_pd();
+
+        for (size_t begin = 0; begin < nLength; begin += anchor_len){
+            size_t end = nLength - begin > anchor_len ? begin + anchor_len : nLength, i;
+            size_t window_begin = begin > window ? begin - window : 0;
+
+            if (n != 0){
+                x_shift += sx / n;
+                y_shift += sy / n;
+            }
+            else{
+                for (i = begin; i != end && isnan(x_data[i] * y_data[i]); ++i);
+                x_shift = i != end ? x_data[i] : 0;
+                y_shift = i != end ? y_data[i] : 0;
+            }
+            n = sx = sy = sxx = syy = sxy = 0;
+            for (i = window_begin; i != begin; ++i){
+                if (!isnan(x_data[i] * y_data[i])){
+                    double dx = x_data[i] - x_shift, dy = y_data[i] - y_shift;
+                    n += 1;
+                    sx += dx;
+                    sy += dy;
+                    sxx += dx * dx;
+                    syy += dy * dy;
+                    sxy += dx * dy;
+                }
+            }
+
+            __m512d avx_x_shift = _mm512_set1_pd(x_shift), avx_y_shift = _mm512_set1_pd(y_shift),
+                    avx_n = _mm512_set1_pd(n), avx_sx = _mm512_set1_pd(sx), avx_sy = _mm512_set1_pd(sy),
+                    avx_sxx = _mm512_set1_pd(sxx), avx_syy = _mm512_set1_pd(syy), avx_sxy = _mm512_set1_pd(sxy),
+                    x_new, y_new, x_old, y_old, avx_res;
+            __mmask8 mask, mask_old, valid_new, valid_old;
+
+            for (size_t index = begin; index < end; index += 8){
+                mask = end - index >= 8 ? 0xff : (1 << (end - index)) - 1;
+                x_new = _mm512_maskz_loadu_pd(mask, x_data+index);
+                y_new = _mm512_maskz_loadu_pd(mask, y_data+index);
+                mask_old = mask;
+                x_old = rolling_load_old(x_data, index, window, mask_old);
+                y_old = rolling_load_old(y_data, index, window, mask_old);
+                valid_new = avx_valid_mask(_mm512_mul_pd(x_new, y_new)) & mask;
+                valid_old = avx_valid_mask(_mm512_mul_pd(x_old, y_old)) & mask_old;
+                __m512d x_same = avx_rolling_run(x_new, valid_new, x_last, x_run),
+                        y_same = avx_rolling_run(y_new, valid_new, y_last, y_run);
+
+                x_new = _mm512_maskz_sub_pd(valid_new, x_new, avx_x_shift);
+                y_new = _mm512_maskz_sub_pd(valid_new, y_new, avx_y_shift);
+                x_old = _mm512_maskz_sub_pd(valid_old, x_old, avx_x_shift);
+                y_old = _mm512_maskz_sub_pd(valid_old, y_old, avx_y_shift);
+                avx_n = avx_prefix_sum(_mm512_sub_pd(_mm512_maskz_mov_pd(valid_new, avx_one),
+                                                    _mm512_maskz_mov_pd(valid_old, avx_one)), avx_n);
+                avx_sx = avx_prefix_sum(_mm512_sub_pd(x_new, x_old), avx_sx);
+                avx_sy = avx_prefix_sum(_mm512_sub_pd(y_new, y_old), avx_sy);
+                avx_sxx = avx_prefix_sum(_mm512_fmsub_pd(x_new, x_new, _mm512_mul_pd(x_old, x_old)), avx_sxx);
+                avx_syy = avx_prefix_sum(_mm512_fmsub_pd(y_new, y_new, _mm512_mul_pd(y_old, y_old)), avx_syy);
+                avx_sxy = avx_prefix_sum(_mm512_fmsub_pd(x_new, y_new, _mm512_mul_pd(x_old, y_old)), avx_sxy);
+
+                __mmask8 x_varying = _mm512_cmp_pd_mask(x_same, avx_n, _CMP_LT_OQ),
+                        y_varying = _mm512_cmp_pd_mask(y_same, avx_n, _CMP_LT_OQ);
+                avx_res = avx_output(avx_n, _mm512_maskz_mov_pd(x_varying, avx_sx), _mm512_maskz_mov_pd(y_varying, avx_sy),
+                                    _mm512_maskz_mov_pd(x_varying, avx_sxx), _mm512_maskz_mov_pd(y_varying, avx_syy),
+                                    _mm512_maskz_mov_pd(x_varying & y_varying, avx_sxy));
+                avx_res = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(avx_n, avx_min_periods, _CMP_LT_OQ),
+                                            avx_res, avx_nan);
+                _mm512_mask_storeu_pd(out+index, mask, avx_res);
+
+                avx_n = avx_last_lane(avx_n);
+                avx_sx = avx_last_lane(avx_sx);
+                avx_sy = avx_last_lane(avx_sy);
+                avx_sxx = avx_last_lane(avx_sxx);
+                avx_syy = avx_last_lane(avx_syy);
+                avx_sxy = avx_last_lane(avx_sxy);
+            }
+            n = _mm512_cvtsd_f64(avx_n);
+            sx = _mm512_cvtsd_f64(avx_sx);
+            sy = _mm512_cvtsd_f64(avx_sy);
+        }
+    }
+
+
+    /**
+     * @brief 由平移后的二阶幂和求中心二阶矩 sum((x-mean)^2)；
+     *        累加误差可能使其略小于 0，此时取 0，窗口内只有一个数时也直接取 0
+     */
+    __attribute__((__always_inline__)) inline __m512d
+    avx_rolling_m2(__m512d n, __m512d s1, __m512d s2)
+    {
+        return _mm512_maskz_max_pd(_mm512_cmp_pd_mask(n, _mm512_set1_pd(1), _CMP_GT_OQ),
+                                _mm512_fnmadd_pd(_mm512_div_pd(s1, n), s1, s2), _mm512_setzero_pd());
+    }
+
+
+    /**
+     * @brief up / down，down 为 0 时为 NaN：
+     *        整个数组的版本此时为 0 / 0，而滚动的 up 带有累加误差，不一定恰好为 0
+     */
+    __attribute__((__always_inline__)) inline __m512d
+    avx_rolling_div(__m512d up, __m512d down)
+    {
+        return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(down, _mm512_setzero_pd(), _CMP_EQ_OQ),
+                                    _mm512_div_pd(up, down), _mm512_set1_pd(NAN));
+    }
+
+
+    /**
+     * @brief 滚动平均，忽略 NaN
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 NaN
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_mean(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                double * __restrict__ out)
+    {
+        rolling_moments<1>(data, nLength, window, min_periods, out,
+            [](__m512d n, __m512d s1, __m512d, __m512d, __m512d, __m512d shift){
+                return _mm512_add_pd(shift, _mm512_div_pd(s1, n));
+            });
+    }
+
+
+    /**
+     * @brief 滚动方差，忽略 NaN
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 NaN
+     * @param bias 是否为有偏估计
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_var(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                bool bias, double * __restrict__ out)
+    {
+        const __m512d ddof = _mm512_set1_pd(bias ? 0 : 1);
+        rolling_moments<2>(data, nLength, window, min_periods, out,
+            [=](__m512d n, __m512d s1, __m512d s2, __m512d, __m512d, __m512d){
+                return avx_rolling_div(avx_rolling_m2(n, s1, s2), _mm512_sub_pd(n, ddof));
+            });
+    }
+
+
+    /**
+     * @brief 滚动标准差，忽略 NaN
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 NaN
+     * @param bias 是否为有偏估计
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_std(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                bool bias, double * __restrict__ out)
+    {
+        const __m512d ddof = _mm512_set1_pd(bias ? 0 : 1);
+        rolling_moments<2>(data, nLength, window, min_periods, out,
+            [=](__m512d n, __m512d s1, __m512d s2, __m512d, __m512d, __m512d){
+                return _mm512_sqrt_pd(avx_rolling_div(avx_rolling_m2(n, s1, s2), _mm512_sub_pd(n, ddof)));
+            });
+    }
+
+
+    /**
+     * @brief 滚动偏度，忽略 NaN，定义与 skew 相同
+     * 窗口很短（2、3 个数）且窗口内数值非常接近时，增量累加的舍入误差会被放大，结果可能只有几位有效数字
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 NaN
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_skew(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                double * __restrict__ out)
+    {
+        rolling_moments<3>(data, nLength, window, min_periods, out,
+            [](__m512d n, __m512d s1, __m512d s2, __m512d s3, __m512d, __m512d){
+                __m512d mean = _mm512_div_pd(s1, n), m2 = avx_rolling_m2(n, s1, s2);
+                // m3 = s3 - mean * (3 * s2 - 2 * mean * s1)
+                __m512d m3 = _mm512_fmsub_pd(_mm512_set1_pd(3), s2,
+                                            _mm512_mul_pd(_mm512_add_pd(mean, mean), s1));
+                m3 = _mm512_fnmadd_pd(mean, m3, s3);
+                return avx_rolling_div(m3, _mm512_sqrt_pd(_mm512_div_pd(avx_pow3(m2), n)));
+            });
+    }
+
+
+    /**
+     * @brief 滚动峰度，忽略 NaN，定义与 kurt 相同
+     * 窗口很短（2、3 个数）且窗口内数值非常接近时，增量累加的舍入误差会被放大，结果可能只有几位有效数字
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 NaN
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_kurt(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                double * __restrict__ out)
+    {
+        rolling_moments<4>(data, nLength, window, min_periods, out,
+            [](__m512d n, __m512d s1, __m512d s2, __m512d s3, __m512d s4, __m512d){
+                __m512d mean = _mm512_div_pd(s1, n), m2 = avx_rolling_m2(n, s1, s2);
+                // m4 = s4 - 4 * mean * s3 + 6 * mean^2 * s2 - 3 * mean^3 * s1
+                __m512d m4 = _mm512_fmadd_pd(_mm512_set1_pd(-3), _mm512_mul_pd(mean, s1),
+                                            _mm512_mul_pd(_mm512_set1_pd(6), s2));
+                m4 = _mm512_fmadd_pd(mean, m4, _mm512_mul_pd(_mm512_set1_pd(-4), s3));
+                m4 = _mm512_fmadd_pd(mean, m4, s4);
+                return avx_rolling_div(_mm512_mul_pd(n, m4), _mm512_mul_pd(m2, m2));
+            });
+    }
+
+
+    /**
+     * @brief 滚动协方差，忽略 NaN：若某组数某处为 NaN，则两组数的该位置都被忽略
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数对少于 min_periods 个时输出 NaN
+     * @param bias 是否为有偏估计
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_covar(const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength,
+                size_t window, size_t min_periods, bool bias, double * __restrict__ out)
+    {
+        const __m512d ddof = _mm512_set1_pd(bias ? 0 : 1);
+        rolling_comoments(x_data, y_data, nLength, window, min_periods, out,
+            [=](__m512d n, __m512d sx, __m512d sy, __m512d, __m512d, __m512d sxy){
+                __m512d up = _mm512_fnmadd_pd(_mm512_div_pd(sx, n), sy, sxy);
+                return avx_rolling_div(up, _mm512_sub_pd(n, ddof));
+            });
+    }
+
+
+    /**
+     * @brief 滚动相关系数，忽略 NaN：若某组数某处为 NaN，则两组数的该位置都被忽略
+     * @param x_data double 数组
+     * @param y_data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数对少于 min_periods 个时输出 NaN
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_corr(const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength,
+                size_t window, size_t min_periods, double * __restrict__ out)
+    {
+        rolling_comoments(x_data, y_data, nLength, window, min_periods, out,
+            [](__m512d n, __m512d sx, __m512d sy, __m512d sxx, __m512d syy, __m512d sxy){
+                __m512d up = _mm512_fnmadd_pd(_mm512_div_pd(sx, n), sy, sxy);
+                __m512d down = _mm512_mul_pd(avx_rolling_m2(n, sx, sxx), avx_rolling_m2(n, sy, syy));
+                __m512d r = avx_rolling_div(up, _mm512_sqrt_pd(down));
+                // 增量累加的舍入误差可能使 |r| 略大于 1，截断到 [-1, 1]（NaN 保持不变）
+                r = _mm512_min_pd(_mm512_set1_pd(1.0), r);
+                return _mm512_max_pd(_mm512_set1_pd(-1.0), r);
+            });
+    }
+
+
+    /**
+     * @brief 滚动的一元线性回归 beta，忽略 NaN：若某组数某处为 NaN，则两组数的该位置都被忽略
+     * @param x_data 自变量
+     * @param y_data 因变量
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数对少于 min_periods 个时输出 NaN
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_beta(const double * __restrict__ x_data, const double * __restrict__ y_data, size_t nLength,
+                size_t window, size_t min_periods, double * __restrict__ out)
+    {
+        rolling_comoments(x_data, y_data, nLength, window, min_periods, out,
+            [](__m512d n, __m512d sx, __m512d sy, __m512d sxx, __m512d, __m512d sxy){
+                __m512d up = _mm512_fnmadd_pd(_mm512_div_pd(sx, n), sy, sxy);
+                return avx_rolling_div(up, avx_rolling_m2(n, sx, sxx));
+            });
+    }
+
+
+    // 滚动最值（van Herk / Gil-Werman）：把数组按 window 个一段分块，
+    // 窗口 [i-window+1, i] 至多跨两段，其最值为前一段从 i-window+1 到段尾的后缀最值
+    // 与本段从段首到 i 的前缀最值中较优的一个。
+    // 前一段的后缀最值错开 window-1 个位置先写入输出数组，再与本段的前缀最值逐个比较，
+    // 每个数只被读两次，与窗口长度无关
+
+    /**
+     * @brief 滚动最小值的比较：earlier 在 later 之前，相等时取 earlier，NaN 总是较差
+     * @return earlier 优于 later 的 lane
+     */
+    struct ROLLING_MIN
+    {
+        __attribute__((__always_inline__)) inline static __mmask8
+        better(__m512d earlier, __m512d later)
+        {
+            return _mm512_cmp_pd_mask(earlier, later, _CMP_LE_OQ) | _mm512_cmp_pd_mask(later, later, _CMP_UNORD_Q);
+        }
+    };
+
+
+    /**
+     * @brief 滚动最大值的比较，同 ROLLING_MIN
+     */
+    struct ROLLING_MAX
+    {
+        __attribute__((__always_inline__)) inline static __mmask8
+        better(__m512d earlier, __m512d later)
+        {
+            return _mm512_cmp_pd_mask(earlier, later, _CMP_GE_OQ) | _mm512_cmp_pd_mask(later, later, _CMP_UNORD_Q);
+        }
+    };
+
+
+    /**
+     * @brief 前缀最值的一步：每个 lane 与前面第 SHIFT 个 lane 比较，移入的 lane 为 NaN、索引为 -1
+     */
+    template <typename CMP, bool INDEX, int SHIFT>
+    __attribute__((__always_inline__)) inline void
+    avx_extreme_step_up(__m512d &x, __m512i &index)
+    {
+        const __m512i avx_none = _mm512_set1_epi64(-1);
+        __m512d earlier = _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(x),
+                                            _mm512_castpd_si512(_mm512_set1_pd(NAN)), 8 - SHIFT));
+        __mmask8 mask = CMP::better(earlier, x);
+        x = _mm512_mask_blend_pd(mask, x, earlier);
+        if (INDEX){
+            index = _mm512_mask_blend_epi64(mask, index, _mm512_alignr_epi64(index, avx_none, 8 - SHIFT));
+        }
+    }
+
+
+    /**
+     * @brief 后缀最值的一步：每个 lane 与后面第 SHIFT 个 lane 比较
+     */
+    template <typename CMP, bool INDEX, int SHIFT>
+    __attribute__((__always_inline__)) inline void
+    avx_extreme_step_down(__m512d &x, __m512i &index)
+    {
+        const __m512i avx_none = _mm512_set1_epi64(-1);
+        __m512d later = _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(_mm512_set1_pd(NAN)),
+                                            _mm512_castpd_si512(x), SHIFT));
+        __mmask8 mask = CMP::better(x, later);
+        x = _mm512_mask_blend_pd(mask, later, x);
+        if (INDEX){
+            index = _mm512_mask_blend_epi64(mask, _mm512_alignr_epi64(avx_none, index, SHIFT), index);
+        }
+    }
+
+
+    /**
+     * @brief 滚动最值共用的内核，忽略 NaN，多个最值相同时取最早的
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内至少要有多少个非 NaN 的数
+     * @param out INDEX 为 false 时的输出数组，不足 min_periods 的位置为 NaN
+     * @param index_out INDEX 为 true 时的输出数组（最值的索引），不足 min_periods 的位置为 (size_t)(-1)
+     */
+    template <typename CMP, bool INDEX>
+    __attribute__((__always_inline__)) inline void
+    rolling_extreme(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                    double * __restrict__ out, size_t * __restrict__ index_out)
+    {
+        const __m512d avx_one = _mm512_set1_pd(1), avx_nan = _mm512_set1_pd(NAN),
+                    avx_min_periods = _mm512_set1_pd(min_periods > 1 ? min_periods : 1);
+        const __m512i avx_none = _mm512_set1_epi64(-1), avx_iota = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+        __m512d avx_x, avx_carry, avx_prev, avx_old, avx_n = _mm512_setzero_pd();
+        __m512i avx_index = avx_none, avx_carry_index, avx_prev_index = avx_none;
+        __mmask8 mask, store_mask, valid_new, valid_old, pick;
+
+        if (window == 0){
+            for (size_t i = 0; i != nLength; ++i){
+                if (INDEX){
+                    index_out[i] = -1;
+                }
+                else{
+                    out[i] = NAN;
+                }
+            }
+            return;
+        }
+
+        for (size_t begin = 0; begin < nLength; begin += window){
+            size_t end = nLength - begin > window ? begin + window : nLength;
+
+            // 前一段 [begin-window, begin) 的后缀最值，下标 j 处的值写到 j+window-1 处；
+            // 前一段的段首对应 begin-1，已经输出过，不写；第一段之前没有数，全部为 NaN
+            if (begin == 0){
+                for (size_t i = 0; i != end; ++i){
+                    if (INDEX){
+                        index_out[i] = -1;
+                    }
+                    else{
+                        out[i] = NAN;
+                    }
+                }
+            }
+            else{
+                const size_t prev = begin - window;
+                if (end == begin + window){
+                    if (INDEX){
+                        index_out[end-1] = -1;
+                    }
+                    else{
+                        out[end-1] = NAN;
+                    }
+                }
+                avx_carry = avx_nan;
+                avx_carry_index = avx_none;
+                for (size_t offset = (window - 1) & ~(size_t)0x7; ; offset -= 8){
+                    size_t j = prev + offset, dest = j + window - 1;
+                    mask = window - offset >= 8 ? 0xff : (1 << (window - offset)) - 1;
+                    avx_x = _mm512_mask_loadu_pd(avx_nan, mask, data+j);
+                    if (INDEX){
+                        avx_index = _mm512_add_epi64(_mm512_set1_epi64(j), avx_iota);
+                    }
+                    avx_extreme_step_down<CMP, INDEX, 1>(avx_x, avx_index);
+                    avx_extreme_step_down<CMP, INDEX, 2>(avx_x, avx_index);
+                    avx_extreme_step_down<CMP, INDEX, 4>(avx_x, avx_index);
+                    pick = CMP::better(avx_x, avx_carry);
+                    avx_x = _mm512_mask_blend_pd(pick, avx_carry, avx_x);
+                    avx_carry = _mm512_permutexvar_pd(_mm512_setzero_si512(), avx_x);
+                    if (INDEX){
+                        avx_index = _mm512_mask_blend_epi64(pick, avx_carry_index, avx_index);
+                        avx_carry_index = _mm512_permutexvar_epi64(_mm512_setzero_si512(), avx_index);
+                    }
+
+                    store_mask = offset == 0 ? mask & 0xfe : mask;
+                    if (dest >= nLength){
+                        store_mask = 0;
+                    }
+                    else if (nLength - dest < 8){
+                        store_mask &= (1 << (nLength - dest)) - 1;
+                    }
+                    if (INDEX){
+                        _mm512_mask_storeu_epi64(index_out+dest, store_mask, avx_index);
+                    }
+                    else{
+                        _mm512_mask_storeu_pd(out+dest, store_mask, avx_x);
+                    }
+                    if (offset == 0){
+                        break;
+                    }
+                }
+            }
+
+            // 本段的前缀最值，与已写入的后缀最值比较；同时滚动统计窗口内非 NaN 的个数
+            avx_carry = avx_nan;
+            avx_carry_index = avx_none;
+            for (size_t index = begin; index < end; index += 8){
+                mask = end - index >= 8 ? 0xff : (1 << (end - index)) - 1;
+                avx_x = _mm512_mask_loadu_pd(avx_nan, mask, data+index);
+                if (INDEX){
+                    avx_index = _mm512_add_epi64(_mm512_set1_epi64(index), avx_iota);
+                }
+                valid_new = avx_valid_mask(avx_x) & mask;
+                valid_old = mask;
+                avx_old = rolling_load_old(data, index, window, valid_old);
+                valid_old = avx_valid_mask(avx_old) & valid_old;
+                avx_n = avx_prefix_sum(_mm512_sub_pd(_mm512_maskz_mov_pd(valid_new, avx_one),
+                                                    _mm512_maskz_mov_pd(valid_old, avx_one)), avx_n);
+
+                avx_extreme_step_up<CMP, INDEX, 1>(avx_x, avx_index);
+                avx_extreme_step_up<CMP, INDEX, 2>(avx_x, avx_index);
+                avx_extreme_step_up<CMP, INDEX, 4>(avx_x, avx_index);
+                pick = CMP::better(avx_carry, avx_x);
+                avx_x = _mm512_mask_blend_pd(pick, avx_x, avx_carry);
+                avx_carry = avx_last_lane(avx_x);
+                if (INDEX){
+                    avx_index = _mm512_mask_blend_epi64(pick, avx_index, avx_carry_index);
+                    avx_carry_index = _mm512_permutexvar_epi64(_mm512_set1_epi64(7), avx_index);
+                    avx_prev_index = _mm512_maskz_loadu_epi64(mask, index_out+index);
+                    avx_prev = _mm512_mask_i64gather_pd(avx_nan,
+                                    _mm512_mask_cmpneq_epi64_mask(mask, avx_prev_index, avx_none),
+                                    avx_prev_index, data, 8);
+                }
+                else{
+                    avx_prev = _mm512_mask_loadu_pd(avx_nan, mask, out+index);
+                }
+
+                pick = CMP::better(avx_prev, avx_x);
+                store_mask = _mm512_cmp_pd_mask(avx_n, avx_min_periods, _CMP_LT_OQ);
+                if (INDEX){
+                    avx_index = _mm512_mask_blend_epi64(pick, avx_index, avx_prev_index);
+                    avx_index = _mm512_mask_blend_epi64(store_mask, avx_index, avx_none);
+                    _mm512_mask_storeu_epi64(index_out+index, mask, avx_index);
+                }
+                else{
+                    avx_x = _mm512_mask_blend_pd(pick, avx_x, avx_prev);
+                    avx_x = _mm512_mask_blend_pd(store_mask, avx_x, avx_nan);
+                    _mm512_mask_storeu_pd(out+index, mask, avx_x);
+                }
+                avx_n = avx_last_lane(avx_n);
+            }
+        }
+    }
+
+
+    /**
+     * @brief 滚动最小值，忽略 NaN
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 NaN
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_min(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                double * __restrict__ out)
+    {
+        rolling_extreme<ROLLING_MIN, false>(data, nLength, window, min_periods, out, NULL);
+    }
+
+
+    /**
+     * @brief 滚动最大值，忽略 NaN
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 NaN
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_max(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                double * __restrict__ out)
+    {
+        rolling_extreme<ROLLING_MAX, false>(data, nLength, window, min_periods, out, NULL);
+    }
+
+
+    /**
+     * @brief 滚动最小值的索引（相对 data 的下标），忽略 NaN，多个最小值相同时取最早的
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 (size_t)(-1)
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_imin(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                size_t * __restrict__ out)
+    {
+        rolling_extreme<ROLLING_MIN, true>(data, nLength, window, min_periods, NULL, out);
+    }
+
+
+    /**
+     * @brief 滚动最大值的索引（相对 data 的下标），忽略 NaN，多个最大值相同时取最早的
+     * @param data double 数组
+     * @param nLength 数组长度
+     * @param window 窗口长度
+     * @param min_periods 窗口内非 NaN 的数少于 min_periods 个时输出 (size_t)(-1)
+     * @param out 输出数组
+     */
+    __attribute__((__always_inline__)) inline void
+    rolling_imax(const double * __restrict__ data, size_t nLength, size_t window, size_t min_periods,
+                size_t * __restrict__ out)
+    {
+        rolling_extreme<ROLLING_MAX, true>(data, nLength, window, min_periods, NULL, out);
+    }
+};
+
+#pragma GCC pop_options
+
+#endif
@@ -111,6 +111,8 @@ namespace SIMPLE_MATH
 
     __attribute__((__always_inline__)) inline double 
     ema(const double *data, size_t nLength, size_t n, size_t k);
+    __attribute__((__always_inline__)) inline void 
+    vec_ema(const double *data, size_t nLength, double span, bool adjust, double *out);
     __attribute__((__always_inline__)) inline double 
     beta(const double *x_data, const double *y_data, size_t nLength);
 
@@ -245,7 +247,6 @@ namespace SIMPLE_MATH
             if (!isnan(tmp)){
                 res += tmp;
             }
-            res += tmp;
         }
         return res;
     }
@@ -642,6 +643,27 @@ namespace SIMPLE_MATH
     }
 
 
+    __attribute__((__always_inline__)) inline void 
+    vec_ema(const double *data, size_t nLength, double span, bool adjust, double *out)
+    {
+        double beta = 2 / (span + 1);
+        double beta_1sub = 1 - beta;
+        double res = NAN, weight = 0;
+        for (size_t i = 0; i < nLength; ++i){
+            if (!isnan(data[i])){
+                if (adjust){
+                    res = isnan(res) ? data[i] : (beta_1sub * weight * res + data[i]) / (beta_1sub * weight + 1);
+                    weight = beta_1sub * weight + 1;
+                }
+                else{
+                    res = isnan(res) ? data[i] : beta_1sub * res + beta * data[i];
+                }
+            }
+            out[i] = res;
+        }
+    }
+
+
     __attribute__((__always_inline__)) inline double 
     beta(const double *x_data, const double *y_data, size_t nLength)
     {
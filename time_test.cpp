@@ -3,38 +3,22 @@
 #include <stdlib.h>
 #include <sched.h>
 #include <cstring>
+#include <cfloat>
+#include <cmath>
 #include <time.h>
+#include <algorithm>
 #include "simple_math.h"
 #include "fast_math.h"
-
-
-__attribute__((__always_inline__)) inline uint64_t
-get_tsc(){
-    uint64_t msr;
-    __asm__ __volatile__ ( 
-        "rdtsc\n\t"    // Returns the time in EDX:EAX.
-        "shl $32, %%rdx\n\t"  // Shift the upper bits left.
-        "or %%rdx, %0"        // 'Or' in the lower bits.
-        : "=a" (msr)
-        : 
-        : "rdx"
-    );
-    return msr;
-}
-
-
-#define PRINT_TSC_SPENT(name, command) \
-    do{ \
-        uint64_t begin, end; \
-        double res = 0; \
-        command \
-        begin = get_tsc(); \
-        command \
-        end = get_tsc(); \
-        std::cout << name << std::endl \
-                << "result: " << res << std::endl \
-                << "tsc spent: " << end-begin << std::endl; \
-    } while (0);
+#include "fast_math_expr.h"
+#include "fast_math_rolling.h"
+#include "fast_math_batch.h"
+#include "fast_math_online.h"
+#include "fast_math_cross.h"
+#include "fast_math_matrix.h"
+#include "fast_math_parallel.h"
+#include "fast_math_executor.h"
+#include "fast_math_alloc.h"
+#include "tsc.h"
 
 
 int main(){
@@ -46,7 +30,12 @@ int main(){
 
     srand(time(NULL));
 
-    cpu_set_t cpuset;
+    // 线程池的线程继承创建时的 CPU 亲和性，要在绑定主线程之前创建
+    FAST_MATH::parallel_pool();
+    FAST_MATH::TASK_EXECUTOR executor;
+
+    cpu_set_t all_cpus, cpuset;
+    sched_getaffinity(0, sizeof(cpu_set_t), &all_cpus);
     CPU_ZERO(&cpuset);
     CPU_SET(24, &cpuset);
     sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
@@ -65,6 +54,7 @@ int main(){
     // x_data[3] = 100;
 
     double *out = new double[length];
+    double *tmp_out = new double[length];
 
     // /* 测试 vec_log 的正确性，尤其注意诸如 NaN, inf 之类特殊值的处理 */
     // double *fast_ls = new double[length], *sim_ls = new double[length];
@@ -307,6 +297,266 @@ int main(){
         "FAST_MATH::vec_log2", 
         FAST_MATH::vec_log2(x_data, length, out);
     )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_log", 
+        FAST_MATH::vec_log(x_data, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_log10", 
+        FAST_MATH::vec_log10(x_data, length, out);
+    )
+    // 数据放得进 L2 时比较每个 tsc 周期处理的个数
+    {
+        const size_t n = length < 4096 ? length : 4096;
+        uint64_t best[3] = {UINT64_MAX, UINT64_MAX, UINT64_MAX};
+        for (int r = 0; r < 1000; ++r){
+            for (int f = 0; f < 3; ++f){
+                uint64_t begin = get_tsc();
+                if (f == 0){
+                    FAST_MATH::vec_log2(x_data, n, out);
+                }
+                else if (f == 1){
+                    FAST_MATH::vec_log(x_data, n, out);
+                }
+                else{
+                    FAST_MATH::vec_log10(x_data, n, out);
+                }
+                uint64_t spent = get_tsc() - begin;
+                best[f] = spent < best[f] ? spent : best[f];
+            }
+        }
+        printf("elements/tsc: vec_log2 %.3f, vec_log %.3f, vec_log10 %.3f\n",
+            (double)n / best[0], (double)n / best[1], (double)n / best[2]);
+    }
+    // 各精度档位相对 long double 结果的最大 ulp 误差，以及数据放得进 L2 时每个 tsc 周期处理的个数
+    {
+        const size_t n = length < 4096 ? length : 4096;
+        for (size_t i = 0; i < length; ++i){
+            tmp_out[i] = 1 + y_data[i] * 1e-4;
+        }
+        auto report = [&](const char *name, auto vec_func, auto ref_func, const double *input){
+            vec_func(input, length, out);
+            double max_ulp = 0, max_rel = 0;
+            for (size_t i = 0; i < length; ++i){
+                long double ref = ref_func(input[i]);
+                int e;
+                frexp((double)ref, &e);
+                double ulp = fabsl(out[i] - ref) / ldexp(1.0, e - 53), rel = fabsl((out[i] - ref) / ref);
+                max_ulp = ulp > max_ulp ? ulp : max_ulp;
+                max_rel = rel > max_rel ? rel : max_rel;
+            }
+            uint64_t best = UINT64_MAX;
+            for (int r = 0; r < 1000; ++r){
+                uint64_t begin = get_tsc();
+                vec_func(input, n, out);
+                uint64_t spent = get_tsc() - begin;
+                best = spent < best ? spent : best;
+            }
+            printf("%-42s max %10.3g ulp (relative %.3g), %.3f elements/tsc\n", name, max_ulp, max_rel, (double)n / best);
+        };
+        auto exp_ref = [](double x){ return expl(x); };
+        auto log_ref = [](double x){ return logl(x); };
+        auto log2_ref = [](double x){ return log2l(x); };
+        std::cout << std::endl;
+        report("vec_exp<LOW_ACCURACY>", FAST_MATH::vec_exp<FAST_MATH::LOW_ACCURACY>, exp_ref, y_data);
+        report("vec_exp<DEFAULT_ACCURACY>", FAST_MATH::vec_exp<FAST_MATH::DEFAULT_ACCURACY>, exp_ref, y_data);
+        report("vec_exp<HIGH_ACCURACY>", FAST_MATH::vec_exp<FAST_MATH::HIGH_ACCURACY>, exp_ref, y_data);
+        report("vec_2pow<HIGH_ACCURACY>", FAST_MATH::vec_2pow<FAST_MATH::HIGH_ACCURACY>,
+            [](double x){ return exp2l(x); }, y_data);
+        report("vec_log2<LOW_ACCURACY>", FAST_MATH::vec_log2<FAST_MATH::LOW_ACCURACY>, log2_ref, x_data);
+        report("vec_log2<DEFAULT_ACCURACY>", FAST_MATH::vec_log2<FAST_MATH::DEFAULT_ACCURACY>, log2_ref, x_data);
+        report("vec_log2<HIGH_ACCURACY>", FAST_MATH::vec_log2<FAST_MATH::HIGH_ACCURACY>, log2_ref, x_data);
+        report("vec_log<LOW_ACCURACY>", FAST_MATH::vec_log<FAST_MATH::LOW_ACCURACY>, log_ref, x_data);
+        report("vec_log<DEFAULT_ACCURACY>", FAST_MATH::vec_log<FAST_MATH::DEFAULT_ACCURACY>, log_ref, x_data);
+        report("vec_log<HIGH_ACCURACY>", FAST_MATH::vec_log<FAST_MATH::HIGH_ACCURACY>, log_ref, x_data);
+        report("vec_log<DEFAULT_ACCURACY> (x near 1)", FAST_MATH::vec_log<FAST_MATH::DEFAULT_ACCURACY>, log_ref, tmp_out);
+        report("vec_log<HIGH_ACCURACY> (x near 1)", FAST_MATH::vec_log<FAST_MATH::HIGH_ACCURACY>, log_ref, tmp_out);
+        report("vec_log10<HIGH_ACCURACY>", FAST_MATH::vec_log10<FAST_MATH::HIGH_ACCURACY>,
+            [](double x){ return log10l(x); }, x_data);
+    }
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "1 / sqrt(x) for each", 
+        for (size_t i = 0; i < length; ++i){
+            out[i] = 1 / sqrt(x_data[i]);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_rsqrt", 
+        FAST_MATH::vec_rsqrt(x_data, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_sqrt", 
+        FAST_MATH::vec_sqrt(x_data, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_clip", 
+        FAST_MATH::vec_clip(y_data, length, -50, 50, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_abs + FAST_MATH::mean", 
+        FAST_MATH::vec_abs(y_data, length, out);
+        res = FAST_MATH::mean(out, length);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::unifunc_mean(ABS())", 
+        res = FAST_MATH::unifunc_mean(FAST_MATH::ABS(), y_data, length);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::mean_abs_dev", 
+        res = FAST_MATH::mean_abs_dev(y_data, length);
+    )
+
+
+
+    // 简单收益率转对数收益率
+    for (size_t i = 0; i < length; ++i){
+        tmp_out[i] = y_data[i] * 1e-4;
+    }
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "log1p for each", 
+        for (size_t i = 0; i < length; ++i){
+            out[i] = log1p(tmp_out[i]);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_log1p", 
+        FAST_MATH::vec_log1p(tmp_out, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "expm1 for each", 
+        for (size_t i = 0; i < length; ++i){
+            out[i] = expm1(tmp_out[i]);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_expm1", 
+        FAST_MATH::vec_expm1(tmp_out, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "pow for each", 
+        for (size_t i = 0; i < length; ++i){
+            out[i] = pow(x_data[i], tmp_out[i]);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_pow", 
+        FAST_MATH::vec_pow(x_data, tmp_out, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_pow<HIGH_ACCURACY>", 
+        FAST_MATH::vec_pow<FAST_MATH::HIGH_ACCURACY>(x_data, tmp_out, length, out);
+    )
+
+
+
+    // 标准正态分布：x 取 [-8, 8]，概率取 (0, 1)
+    for (size_t i = 0; i < length; ++i){
+        tmp_out[i] = y_data[i] * 0.08;
+    }
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "erf for each", 
+        for (size_t i = 0; i < length; ++i){
+            out[i] = erf(tmp_out[i]);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_erf", 
+        FAST_MATH::vec_erf(tmp_out, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "erfc for each", 
+        for (size_t i = 0; i < length; ++i){
+            out[i] = erfc(tmp_out[i]);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_erfc", 
+        FAST_MATH::vec_erfc(tmp_out, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "0.5 * erfc(-x / sqrt(2)) for each", 
+        for (size_t i = 0; i < length; ++i){
+            out[i] = 0.5 * erfc(-tmp_out[i] * M_SQRT1_2);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_norm_cdf", 
+        FAST_MATH::vec_norm_cdf(tmp_out, length, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_norm_ppf", 
+        FAST_MATH::vec_norm_ppf(out, length, tmp_out);
+    )
+    std::cout << std::endl;
+    /* 特殊值与远尾部（如 ±1e300、-DBL_MAX）：与 libm 不一致时打印 F */
+    {
+        double special[] = {-DBL_MAX, -1e300, -1e100, -1e28, -40, -38, -27, -10, 0, 
+                            10, 27, 38, 1e300, DBL_MAX, -INFINITY, INFINITY, NAN};
+        const size_t n_special = sizeof(special) / sizeof(double);
+        double cdf[n_special], erfc_out[n_special], erf_out[n_special];
+        FAST_MATH::vec_norm_cdf(special, n_special, cdf);
+        FAST_MATH::vec_erfc(special, n_special, erfc_out);
+        FAST_MATH::vec_erf(special, n_special, erf_out);
+        // 相对误差 1e-14 以内，或都为 NaN；N(x) 的参考值用 long double 算，double 下 x / sqrt(2) 的舍入误差在尾部会放大
+        auto close = [](double v, double ref){
+            return v == ref || std::fabs(v - ref) <= 1e-14 * std::fabs(ref) + 1e-320 || (std::isnan(v) && std::isnan(ref));
+        };
+        for (size_t i = 0; i < n_special; ++i){
+            double ref_cdf = 0.5L * erfcl(-special[i] / sqrtl(2));
+            if (!close(cdf[i], ref_cdf) || !close(erfc_out[i], erfc(special[i])) || !close(erf_out[i], erf(special[i]))){
+                printf("F\t%le\t%le\t%le\t%le\n", special[i], cdf[i], erfc_out[i], erf_out[i]);
+            }
+        }
+    }
 
 
 
@@ -324,6 +574,18 @@ int main(){
         for (int i = 0; i < 100; ++i)
         res = FAST_MATH::ema(x_data, length/5, length);
     )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "SIMPLE_MATH::vec_ema", 
+        SIMPLE_MATH::vec_ema(x_data, length, 20, false, out);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_ema", 
+        FAST_MATH::vec_ema(x_data, length, 20, false, out);
+    )
 
 
 
@@ -341,6 +603,365 @@ int main(){
     )
 
 
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "std::nth_element median", 
+        memcpy(tmp_out, x_data, sizeof(double) * length);
+        std::nth_element(tmp_out, tmp_out + length / 2, tmp_out + length);
+        res = tmp_out[length / 2];
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::median", 
+        res = FAST_MATH::median(x_data, length, tmp_out);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "std::sort", 
+        memcpy(tmp_out, x_data, sizeof(double) * length);
+        std::sort(tmp_out, tmp_out + length);
+        res = tmp_out[length / 2];
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::sort", 
+        memcpy(tmp_out, x_data, sizeof(double) * length);
+        FAST_MATH::sort(tmp_out, length);
+        res = tmp_out[length / 2];
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::vec_log + FAST_MATH::mean", 
+        for (size_t i = 0; i < length; ++i){
+            tmp_out[i] = x_data[i] / y_data[i];
+        }
+        FAST_MATH::vec_log(tmp_out, length, out);
+        res = FAST_MATH::mean(out, length);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::expr log().mean()", 
+        res = (FAST_MATH::expr(x_data, length) / FAST_MATH::expr(y_data, length)).log().mean();
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    const size_t window = 240;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::var for each window", 
+        for (size_t i = 0; i < length; ++i){
+            size_t begin = i + 1 >= window ? i + 1 - window : 0;
+            out[i] = FAST_MATH::var(x_data + begin, i + 1 - begin, false);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::rolling_var", 
+        FAST_MATH::rolling_var(x_data, length, window, 1, false, out);
+    )
+    std::cout << std::endl;
+    /* 价格不变的窗口（tick 数据中很常见）：之前的数留下的累加误差不能让 std 偏离 0，beta / corr 应为 NaN */
+    {
+        size_t flat_len = 4 * window;
+        double *flat_x = new double[flat_len], *flat_y = new double[flat_len];
+        double *flat_std = new double[flat_len], *flat_beta = new double[flat_len], *flat_corr = new double[flat_len];
+        for (size_t i = 0; i < flat_len; ++i){
+            flat_x[i] = i < window ? x_data[i % length] : 100.01;
+            flat_y[i] = y_data[i % length];
+        }
+        FAST_MATH::rolling_std(flat_x, flat_len, window, 1, false, flat_std);
+        FAST_MATH::rolling_beta(flat_x, flat_y, flat_len, window, 1, flat_beta);
+        FAST_MATH::rolling_corr(flat_x, flat_y, flat_len, window, 1, flat_corr);
+        for (size_t i = 2 * window; i < flat_len; ++i){
+            if (flat_std[i] != 0 || !std::isnan(flat_beta[i]) || !std::isnan(flat_corr[i])){
+                printf("F\trolling on a flat window at %zu: std %le, beta %le, corr %le\n", i, flat_std[i], flat_beta[i], flat_corr[i]);
+                break;
+            }
+        }
+        delete[] flat_x;
+        delete[] flat_y;
+        delete[] flat_std;
+        delete[] flat_beta;
+        delete[] flat_corr;
+    }
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::max for each window", 
+        for (size_t i = 0; i < length; ++i){
+            size_t begin = i + 1 >= window ? i + 1 - window : 0;
+            out[i] = FAST_MATH::max(x_data + begin, i + 1 - begin);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::rolling_max", 
+        FAST_MATH::rolling_max(x_data, length, window, 1, out);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    const size_t n_rows = 20, n_cols = length / n_rows;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::var for each column", 
+        for (size_t j = 0; j < n_cols; ++j){
+            for (size_t t = 0; t < n_rows; ++t){
+                tmp_out[t] = x_data[t * n_cols + j];
+            }
+            out[j] = FAST_MATH::var(tmp_out, n_rows, false);
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::batch_var", 
+        FAST_MATH::batch_var(x_data, n_rows, n_cols, false, out);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    const size_t cs_cols = 5000, cs_rows = length / cs_cols;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::mean + FAST_MATH::std for each row", 
+        memcpy(tmp_out, x_data, sizeof(double) * length);
+        for (size_t t = 0; t < cs_rows; ++t){
+            double *row = tmp_out + t * cs_cols;
+            double row_mean = FAST_MATH::mean(row, cs_cols);
+            double row_std = FAST_MATH::std(row, cs_cols, false);
+            for (size_t j = 0; j < cs_cols; ++j){
+                row[j] = (row[j] - row_mean) / row_std;
+            }
+        }
+        res = tmp_out[0];
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::cs_zscore", 
+        memcpy(tmp_out, x_data, sizeof(double) * length);
+        FAST_MATH::cs_zscore(tmp_out, cs_rows, cs_cols);
+        res = tmp_out[0];
+    )
+    std::cout << std::endl;
+    /* 稀疏的行业代码与压缩后的 0 ~ 4 分组结果应相同 */
+    if (cs_rows != 0){
+        const int codes[5] = {801010, 801020, 801030, 801040, 801050};
+        int *sparse_group = new int[cs_cols], *dense_group = new int[cs_cols];
+        for (size_t j = 0; j < cs_cols; ++j){
+            dense_group[j] = j % 7 < 5 ? j % 7 : -1;
+            sparse_group[j] = j % 7 < 5 ? codes[j % 7] : -1;
+        }
+        memcpy(tmp_out, x_data, sizeof(double) * cs_cols);
+        memcpy(out, x_data, sizeof(double) * cs_cols);
+        FAST_MATH::cs_zscore(tmp_out, 1, cs_cols, sparse_group);
+        FAST_MATH::cs_zscore(out, 1, cs_cols, dense_group);
+        for (size_t j = 0; j < cs_cols; ++j){
+            if (!(tmp_out[j] == out[j] || (std::isnan(tmp_out[j]) && std::isnan(out[j])))){
+                printf("F\tcs_zscore with sparse group ids at %zu: %le, %le\n", j, tmp_out[j], out[j]);
+                break;
+            }
+        }
+        delete[] sparse_group;
+        delete[] dense_group;
+    }
+
+
+
+    std::cout << std::endl << split << std::endl;
+    const size_t mat_cols = 200, mat_rows = length / mat_cols;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::corr for each pair", 
+        for (size_t j = 0; j < mat_cols; ++j){
+            for (size_t t = 0; t < mat_rows; ++t){
+                tmp_out[j * mat_rows + t] = x_data[t * mat_cols + j];
+            }
+        }
+        for (size_t i = 0; i < mat_cols; ++i){
+            for (size_t j = 0; j < mat_cols; ++j){
+                out[i * mat_cols + j] = FAST_MATH::corr(tmp_out + i * mat_rows, tmp_out + j * mat_rows, mat_rows);
+            }
+        }
+        res = out[1];
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::corr_matrix", 
+        FAST_MATH::corr_matrix(x_data, mat_rows, mat_cols, out);
+        res = out[1];
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    const size_t ols_k = 10, ols_rows = length / ols_k;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::beta", 
+        res = FAST_MATH::beta(x_data, y_data, ols_rows);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::ols, 10 factors", 
+        res = FAST_MATH::ols(x_data, y_data, ols_k, ols_rows, out);
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::var", 
+        res = FAST_MATH::var(x_data, length, false);
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::parallel_var", 
+        res = FAST_MATH::parallel_var(x_data, length, false);
+    )
+    std::cout << std::endl;
+    /* 开头整块都是 NaN 时 parallel_imin / parallel_imax 要与 imin / imax 一致，全是 NaN 时返回 (uint64_t)(-1) */
+    {
+        size_t nan_len = 3 * FAST_MATH::PARALLEL_CHUNK;
+        double *nan_data = new double[nan_len];
+        for (size_t i = 0; i < nan_len; ++i){
+            nan_data[i] = i < FAST_MATH::PARALLEL_CHUNK ? NAN : x_data[i % length];
+        }
+        if (FAST_MATH::parallel_imin(nan_data, nan_len) != FAST_MATH::imin(nan_data, nan_len) || 
+            FAST_MATH::parallel_imax(nan_data, nan_len) != FAST_MATH::imax(nan_data, nan_len)){
+            printf("F\tparallel_imin / parallel_imax with a leading all-NaN chunk\n");
+        }
+        for (size_t i = 0; i < nan_len; ++i){
+            nan_data[i] = NAN;
+        }
+        if (FAST_MATH::parallel_imin(nan_data, nan_len) != (size_t)-1 || FAST_MATH::parallel_imax(nan_data, nan_len) != (size_t)-1){
+            printf("F\tparallel_imin / parallel_imax on all-NaN input\n");
+        }
+        delete[] nan_data;
+    }
+
+
+
+    std::cout << std::endl << split << std::endl;
+    // 放得进 L1 的 512 个数：从 64 字节对齐的 FAST_MATH::vector 与错开一个 double 的位置各求和 10000 次；
+    // 空的 asm 让编译器每次都重新读数，不会把求和提到循环外
+    FAST_MATH::vector<double> l1_data(x_data, x_data + 520);
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::sum, L1, aligned", 
+        for (size_t k = 0; k < 10000; ++k){
+            res += FAST_MATH::sum(l1_data.data(), 512);
+            __asm__ volatile("" ::: "memory");
+        }
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::sum, L1, misaligned", 
+        for (size_t k = 0; k < 10000; ++k){
+            res += FAST_MATH::sum(l1_data.data() + 1, 512);
+            __asm__ volatile("" ::: "memory");
+        }
+    )
+
+
+
+    std::cout << std::endl << split << std::endl;
+    // 内存带宽：new 分配、由主线程初始化的数组与 parallel_alloc 按节点初始化的数组，线程数从 1 倍增到全部；
+    // 测量时不绑定主线程，重建的工作线程才能用到所有的核
+    {
+        size_t max_threads = FAST_MATH::parallel_pool().size();
+        sched_setaffinity(0, sizeof(cpu_set_t), &all_cpus);
+        double *numa_data = FAST_MATH::parallel_alloc(length);
+        memcpy(numa_data, x_data, sizeof(double) * length);
+        double res = 0;
+        for (size_t threads = 1; ; threads = threads * 2 < max_threads ? threads * 2 : max_threads){
+            FAST_MATH::set_num_threads(threads);
+            uint64_t tsc_new = get_tsc();
+            res = FAST_MATH::parallel_sum(x_data, length);
+            tsc_new = get_tsc() - tsc_new;
+            uint64_t tsc_numa = get_tsc();
+            res += FAST_MATH::parallel_sum(numa_data, length);
+            tsc_numa = get_tsc() - tsc_numa;
+            printf("parallel_sum, %zu threads: new %.2f bytes/tsc, parallel_alloc %.2f bytes/tsc, result %g\n", threads,
+                8.0 * length / tsc_new, 8.0 * length / tsc_numa, res);
+            if (threads == max_threads){
+                break;
+            }
+        }
+        FAST_MATH::parallel_free(numa_data, length);
+        sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+    }
+
+
+
+    std::cout << std::endl << split << std::endl;
+    // 长短不一的序列：第 t 个任务计算前 task_len[t] 个值的 corr
+    const size_t n_tasks = 256;
+    size_t *task_len = new size_t[n_tasks];
+    FAST_MATH::TASK_BATCH batch;
+    for (size_t t = 0; t < n_tasks; ++t){
+        task_len[t] = (t * t * 7919) % length + 1;
+        batch.add([=]{ out[t] = FAST_MATH::corr(x_data, y_data, task_len[t]); }, task_len[t]);
+    }
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::corr for each task", 
+        for (size_t t = 0; t < n_tasks; ++t){
+            out[t] = FAST_MATH::corr(x_data, y_data, task_len[t]);
+        }
+        res = out[1];
+    )
+    std::cout << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::TASK_EXECUTOR", 
+        executor.run(batch);
+        res = out[1];
+    )
+    batch.print_stats(3);
+    delete[] task_len;
+
+
+
+    std::cout << std::endl << split << std::endl;
+    PRINT_TSC_SPENT
+    (
+        "FAST_MATH::ONLINE_MOMENTS push", 
+        {
+            FAST_MATH::ONLINE_MOMENTS online;
+            for (size_t i = 0; i < length; ++i){
+                online.push(x_data[i]);
+            }
+            res = online.var(false);
+        }
+    )
+
+
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef TSC_H
+#define TSC_H
+
+#include <iostream>
+#include <stdint.h>
+
+
+__attribute__((__always_inline__)) inline uint64_t
+get_tsc(){
+    uint64_t msr;
+    __asm__ __volatile__ ( 
+        "rdtsc\n\t"    // Returns the time in EDX:EAX.
+        "shl $32, %%rdx\n\t"  // Shift the upper bits left.
+        "or %%rdx, %0"        // 'Or' in the lower bits.
+        : "=a" (msr)
+        : 
+        : "rdx"
+    );
+    return msr;
+}
+
+
+#define PRINT_TSC_SPENT(name, command) \
+    do{ \
+        uint64_t begin, end; \
+        double res = 0; \
+        command \
+        begin = get_tsc(); \
+        command \
+        end = get_tsc(); \
+        std::cout << name << std::endl \
+                << "result: " << res << std::endl \
+                << "tsc spent: " << end-begin << std::endl; \
+    } while (0);
+
+#endif